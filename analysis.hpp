@@ -0,0 +1,236 @@
+/*!
+ * \file atasol_analysis.hpp
+ * \brief atasol batch analysis of many statuses
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_ANALYSIS_HPP_
+#define ATASOL_ANALYSIS_HPP_
+
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nnue.hpp"
+#include "search.hpp"
+#include "solver.hpp"
+#include "tablebase.hpp"
+#include "uai.hpp"
+
+namespace atasol {
+	//! Append a string to a JSON document as a string value, escaping what JSON requires
+	inline void appendJsonString(std::string & out, std::string const & s)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+		out += '"';
+		for(const char c : s) {
+			if(c == '"' || c == '\\') {
+				out += '\\';
+				out += c;
+			} else if(static_cast<unsigned char>(c) < 0x20) {
+				out += "\\u00";
+				out += hex[static_cast<unsigned char>(c) >> 4];
+				out += hex[static_cast<unsigned char>(c) & 0xf];
+			} else {
+				out += c;
+			}
+		}
+		out += '"';
+	}
+
+	//! Append moves to a JSON document as an array of strings in UAI notation
+	template<uint32_t Size>
+		void appendJsonMoves(std::string & out, std::vector<Move> const & moves)
+		{
+			out += '[';
+			for(std::size_t i = 0; i != moves.size(); ++i) {
+				out += i == 0 ? "\"" : ",\"";
+				appendUaiMove<Size>(out, moves[i]);
+				out += '"';
+			}
+			out += ']';
+		}
+
+	//! Append SearchStats to a JSON document as an object, with the times of the iterations in milliseconds
+	inline void appendJsonStats(std::string & out, SearchStats const & stats)
+	{
+		out += "{\"evaluations\":";
+		out += std::to_string(stats.evaluations);
+		out += ",\"cutoffs\":";
+		out += std::to_string(stats.cutoffs);
+		out += ",\"firstMoveCutoffs\":";
+		out += std::to_string(stats.firstMoveCutoffs);
+		out += ",\"firstMoveCutoffRate\":";
+		out += std::to_string(stats.firstMoveCutoffRate());
+		out += ",\"tableProbes\":";
+		out += std::to_string(stats.tableProbes);
+		out += ",\"tableHits\":";
+		out += std::to_string(stats.tableHits);
+		out += ",\"tableHitRate\":";
+		out += std::to_string(stats.tableHitRate());
+		out += ",\"branchingFactor\":";
+		out += std::to_string(stats.branchingFactor());
+		out += ",\"iterations\":[";
+		for(std::size_t i = 0; i != stats.iterations.size(); ++i) {
+			out += i == 0 ? "{\"depth\":" : ",{\"depth\":";
+			out += std::to_string(stats.iterations[i].depth);
+			out += ",\"nodes\":";
+			out += std::to_string(stats.iterations[i].nodes);
+			out += ",\"ms\":";
+			out += std::to_string(std::chrono::duration<double, std::milli>(stats.iterations[i].time).count());
+			out += '}';
+		}
+		out += "]}";
+	}
+
+	//! Analyse statuses given as FEN lines, writing one JSON line per status as soon as its search is done
+	/*!
+	 * Lines are handed out in order to a pool of worker threads, each with its own Searcher and a share of the TranspositionTable memory,
+	 * so results come out in the order their searches finish. Every result carries the number of its line, counting from one, and its FEN.
+	 * It has either an error, or the best move and principal variation in UAI notation, the score in centiblobs from the point of view
+	 * of the moving player as in UAI info lines, the depth of the last completed iteration, the nodes, the time in milliseconds
+	 * and the SearchStats, see appendJsonStats():
+	 *
+	 *     {"line":1,"fen":"x5o/7/7/7/7/7/o5x x 0 1","move":"b6","cp":100,"depth":9,"nodes":123456,"ms":31,"pv":["b6","f6"],"stats":{...}}
+	 *
+	 * With SearchLimits::multiPv above one, the ranked root moves follow the principal variation as "lines",
+	 * each with its move, exact score and principal variation like the best one: "lines":[{"move":"b6","cp":100,"pv":["b6","f6"]},...]
+	 *
+	 * Whitespace around a FEN, such as the carriage return of a Windows line end, is removed and lines left empty are skipped.
+	 * Each worker formats into one buffer that it reuses for all of its lines.
+	 * \param[in] in The FEN lines
+	 * \param[out] out Where the JSON lines are written to and flushed
+	 * \param[in] limits The depth, time and number of ranked root moves of every search
+	 * \param[in] threads The number of worker threads
+	 * \param[in] hashMegabytes The size of all TranspositionTables together
+	 * \param[in] tablebase The Tablebase that the searches probe, or nullptr
+	 * \param[in] network The Network that evaluates statuses, or nullptr to use BasicStatus::evaluation()
+	 * \return Whether every line was a valid FEN of a Size x Size board
+	 */
+	template<uint32_t Size>
+		bool analyse(std::istream & in, std::ostream & out, SearchLimits const & limits, const uint32_t threads, const std::size_t hashMegabytes,
+				Tablebase<Size> const * tablebase = nullptr, Network<Size> const * network = nullptr)
+		{
+			std::mutex inMutex;
+			uint64_t lineNumber = 0;
+			std::mutex outMutex;
+			std::atomic<bool> valid{true};
+			const auto workerCount = std::max(threads, 1U);
+
+			const auto work = [&] {
+				TranspositionTable table(std::max<std::size_t>(hashMegabytes / workerCount, 1));
+				BasicSearcher<Size> searcher(&table, 0, tablebase, network);
+				std::string fen;
+				std::string json;
+				for(;;) {
+					uint64_t number;
+					{
+						std::lock_guard<std::mutex> lock(inMutex);
+						do {
+							if(!std::getline(in, fen)) {
+								return;
+							}
+							++lineNumber;
+							const auto last = fen.find_last_not_of(" \t\r\n\v\f");
+							fen.erase(last == std::string::npos ? 0 : last + 1);
+							fen.erase(0, fen.find_first_not_of(" \t\r\n\v\f"));
+						} while(fen.empty());
+						number = lineNumber;
+					}
+
+					json.clear();
+					json += "{\"line\":";
+					json += std::to_string(number);
+					json += ",\"fen\":";
+					appendJsonString(json, fen);
+					BasicStatus<Size> status;
+					if(fenBoardSize(fen) != Size || !parseFen(fen, status)) {
+						valid.store(false, std::memory_order_relaxed);
+						json += ",\"error\":\"invalid FEN for a ";
+						json += std::to_string(Size);
+						json += 'x';
+						json += std::to_string(Size);
+						json += " board\"}\n";
+					} else {
+						const auto start = std::chrono::steady_clock::now();
+						const auto result = searcher.search(status, limits);
+						const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+						json += ",\"move\":\"";
+						appendUaiMove<Size>(json, result.move);
+						json += "\",\"cp\":";
+						json += std::to_string(100 * (status.whiteMoves() ? result.score : - result.score) / blobScore);
+						json += ",\"depth\":";
+						json += std::to_string(result.depth);
+						json += ",\"nodes\":";
+						json += std::to_string(result.nodes);
+						json += ",\"ms\":";
+						json += std::to_string(milliseconds);
+						json += ",\"pv\":";
+						appendJsonMoves<Size>(json, result.pv);
+						if(!result.lines.empty()) {
+							json += ",\"lines\":[";
+							for(std::size_t i = 0; i != result.lines.size(); ++i) {
+								json += i == 0 ? "{\"move\":\"" : ",{\"move\":\"";
+								appendUaiMove<Size>(json, result.lines[i].move);
+								json += "\",\"cp\":";
+								json += std::to_string(100 * (status.whiteMoves() ? result.lines[i].score : - result.lines[i].score) / blobScore);
+								json += ",\"pv\":";
+								appendJsonMoves<Size>(json, result.lines[i].pv);
+								json += '}';
+							}
+							json += ']';
+						}
+						json += ",\"stats\":";
+						appendJsonStats(json, result.stats);
+						json += "}\n";
+					}
+
+					std::lock_guard<std::mutex> lock(outMutex);
+					out.write(json.data(), static_cast<std::streamsize>(json.size()));
+					out.flush();
+				}
+			};
+
+			std::vector<std::thread> workers;
+			for(uint32_t i = 1; i < workerCount; ++i) {
+				workers.emplace_back(work);
+			}
+			work();
+			for(auto & worker : workers) {
+				worker.join();
+			}
+			return valid.load();
+		}
+}
+
+#endif
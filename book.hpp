@@ -0,0 +1,240 @@
+/*!
+ * \file atasol_book.hpp
+ * \brief atasol opening book
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_BOOK_HPP_
+#define ATASOL_BOOK_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "mapping.hpp"
+#include "search.hpp"
+#include "solver.hpp"
+
+namespace atasol {
+	//! The best move of one Status as stored in an OpeningBook
+	struct BookEntry
+	{
+		//! The Zobrist key of the canonical Status, see BasicStatus::canonical()
+		uint64_t key;
+		//! The best move of the canonical Status, which probe() turns back into a move of the probed Status
+		Move move;
+		//! The score of the Status, positive values being good for white as with BasicStatus::evaluation()
+		int16_t score;
+		//! The depth of the search that found move
+		uint32_t depth;
+	};
+
+	static_assert(sizeof(BookEntry) == 16 && std::is_trivially_copyable<BookEntry>::value, "BookEntry is stored as it is.");
+
+	//! Best moves for the statuses of the first moves of a game, found by deep searches ahead of time
+	/*!
+	 * The file is a header followed by BookEntry structs sorted by key, in the byte order of the machine that built it.
+	 * It is mapped into memory and searched in place, so opening it does not read or parse anything.
+	 * Only one of every set of symmetric statuses is stored, which makes books of symmetric openings up to eight times smaller.
+	 */
+	template<uint32_t Size>
+		class OpeningBook
+		{
+			public:
+				//! Map a file written by build(), replacing any file opened before
+				/*!
+				 * \return Whether path is a book of this board size
+				 */
+				bool open(std::string const & path)
+				{
+					if(!file_.open(path)) {
+						return false;
+					}
+					if(file_.size() < headerSize || (file_.size() - headerSize) % sizeof(BookEntry) != 0
+							|| std::memcmp(file_.data(), header().data(), header().size()) != 0) {
+						file_.close();
+						return false;
+					}
+					return true;
+				}
+
+				//! Whether a file is open
+				bool isOpen() const noexcept
+				{
+					return file_.data() != nullptr;
+				}
+
+				//! The number of statuses in the book
+				std::size_t size() const noexcept
+				{
+					return isOpen() ? (file_.size() - headerSize) / sizeof(BookEntry) : 0;
+				}
+
+				//! Look up a Status
+				/*!
+				 * \param[in] status The Status
+				 * \param[out] entry Receives the entry of status if there is one, with the move turned to status
+				 * \return Whether status is in the book with a move that is legal in it
+				 */
+				bool probe(BasicStatus<Size> const & status, BookEntry & entry) const noexcept
+				{
+					if(!isOpen()) {
+						return false;
+					}
+					const auto symmetry = status.canonicalSymmetry();
+					const auto key = status.transformed(symmetry).key();
+					// The mapped bytes are not BookEntry objects, so keys and entries are copied out of them.
+					const auto entries = file_.data() + headerSize;
+					std::size_t first = 0;
+					std::size_t last = size();
+					while(first != last) {
+						const auto middle = first + (last - first) / 2;
+						uint64_t middleKey;
+						std::memcpy(&middleKey, entries + middle * sizeof(BookEntry), sizeof(middleKey));
+						if(middleKey < key) {
+							first = middle + 1;
+						} else {
+							last = middle;
+						}
+					}
+					if(first == size()) {
+						return false;
+					}
+					BookEntry e;
+					std::memcpy(&e, entries + first * sizeof(BookEntry), sizeof(e));
+					if(e.key != key) {
+						return false;
+					}
+					e.move = restoreMove<Size>(e.move, symmetry);
+					// Guard against another status having the same key.
+					std::array<Move, upperLimitMoves<Size>> moves;
+					const auto len = generateMoves(status, moves.begin());
+					if(std::find(moves.begin(), moves.begin() + len, e.move) == moves.begin() + len) {
+						return false;
+					}
+					entry = e;
+					return true;
+				}
+
+				//! Search all statuses of the first moves of a game and write their best moves to a file that open() accepts
+				/*!
+				 * Every move of both players is followed, so the book answers whatever the opponent plays.
+				 * Statuses where the game is over or the moving player has to pass are left out.
+				 * \param[in] start The Status the game starts with
+				 * \param[in] plies The number of moves the book covers, the last one being played from statuses reached after plies - 1 moves
+				 * \param[in] limits The limits of every search
+				 * \param[in] threads The number of statuses searched at once
+				 * \param[in] hashMegabytes The size of the TranspositionTable shared by all searches
+				 * \param[in] path The file to write
+				 * \param[out] entries Receives the number of statuses in the book
+				 * \return Whether the file was written
+				 */
+				static bool build(BasicStatus<Size> const & start, const uint32_t plies, SearchLimits const & limits, const uint32_t threads,
+						const std::size_t hashMegabytes, std::string const & path, std::size_t & entries)
+				{
+					// Collect every status reachable within plies - 1 moves once, up to symmetry.
+					std::vector<BasicStatus<Size>> statuses;
+					{
+						std::unordered_set<uint64_t> seen{start.canonical().key()};
+						std::vector<BasicStatus<Size>> level{start.canonical()};
+						for(uint32_t ply = 0; ply != plies && !level.empty(); ++ply) {
+							std::vector<BasicStatus<Size>> nextLevel;
+							for(auto const & status : level) {
+								std::array<Move, upperLimitMoves<Size>> moves;
+								const auto len = generateMoves(status, moves.begin());
+								if(status.gameOver() || len == 0) {
+									continue;
+								}
+								statuses.push_back(status);
+								if(ply + 1 == plies) {
+									continue;
+								}
+								for(uint32_t i = 0; i != len; ++i) {
+									auto child = status;
+									child.makeMove(moves[i]);
+									child = child.canonical();
+									if(seen.insert(child.key()).second) {
+										nextLevel.push_back(child);
+									}
+								}
+							}
+							level.swap(nextLevel);
+						}
+					}
+
+					std::vector<BookEntry> book(statuses.size());
+					TranspositionTable table(hashMegabytes);
+					// The workers share one generation of the table, so that none of them ages the entries of the others.
+					table.newSearch();
+					SearchLimits workerLimits = limits;
+					workerLimits.ageTable = false;
+					std::atomic<std::size_t> nextStatus{0};
+					std::vector<std::thread> workers;
+					for(uint32_t t = 0; t != std::max(threads, 1U); ++t) {
+						workers.emplace_back([&] {
+							BasicSearcher<Size> searcher(&table);
+							for(auto i = nextStatus++; i < statuses.size(); i = nextStatus++) {
+								const auto result = searcher.search(statuses[i], workerLimits);
+								book[i] = BookEntry{statuses[i].key(), result.move, static_cast<int16_t>(result.score), result.depth};
+							}
+						});
+					}
+					for(auto & worker : workers) {
+						worker.join();
+					}
+					std::sort(book.begin(), book.end(), [] (BookEntry const & lhs, BookEntry const & rhs) { return lhs.key < rhs.key; });
+
+					std::ofstream file(path, std::ios::binary | std::ios::trunc);
+					file.write(header().data(), static_cast<std::streamsize>(header().size()));
+					file.write(reinterpret_cast<char const *>(book.data()), static_cast<std::streamsize>(book.size() * sizeof(BookEntry)));
+					entries = book.size();
+					return static_cast<bool>(file);
+				}
+
+			private:
+				//! The size of the header, which is "atasolbk" followed by the board size as a digit, 'c' for canonical keys and padding
+				static constexpr std::size_t headerSize = 16;
+
+				static std::array<char, headerSize> header() noexcept
+				{
+					std::array<char, headerSize> r{{'a', 't', 'a', 's', 'o', 'l', 'b', 'k', static_cast<char>('0' + Size), 'c'}};
+					return r;
+				}
+
+				//! The header followed by the entries
+				MappedFile file_;
+		};
+}
+
+#endif
@@ -29,28 +29,59 @@
 // Uncomment to plya black
 //#define BLACKHUMAN
 
-// Depth of white computer player
+// Default depth of white computer player, may be overridden by the first argument
 #define WHITEDEPTH 5
 
-// Depth of black computer player
+// Default depth of black computer player, may be overridden by the second argument
 #define BLACKDEPTH 3
 
+// Default size of the transposition table shared by both computer players in megabytes, may be overridden by --hash
+#define HASHMEGABYTES 64
+
+// Default number of search threads, may be overridden by --threads
+#define THREADS 1
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <regex>
+#include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "analysis.hpp"
+#include "book.hpp"
+#include "match.hpp"
+#include "nnue.hpp"
+#include "perft.hpp"
+#include "search.hpp"
+#include "selfplay.hpp"
 #include "solver.hpp"
+#include "tablebase.hpp"
+#include "uai.hpp"
 
 namespace {
 #if defined(WHITEHUMAN) || defined(BLACKHUMAN)
-	inline std::pair<bool, atasol::Status> getHumanInput(atasol::Status const & status)
+	template<uint32_t Size>
+	std::pair<bool, atasol::BasicStatus<Size>> getHumanInput(atasol::BasicStatus<Size> const & status)
 	{
 		using namespace atasol;
-		std::array<Status, upperLimitMoves> possibleMoves;
-		const auto numMoves = generateStatuses(status, possibleMoves.begin());
+		std::array<Move, upperLimitMoves<Size>> possibleMoves;
+		const auto numMoves = generateMoves(status, possibleMoves.begin());
 		std::string i;
-		Status newStatus;
+		BasicStatus<Size> newStatus;
+		if(numMoves == 0) {
+			std::cout << "> pass\n";
+			newStatus = status;
+			newStatus.switchPlayerTurn();
+			return std::make_pair(true, newStatus);
+		}
 		for(;;) {
 			newStatus = status;
 			i.clear();
@@ -64,7 +95,7 @@ namespace {
 
 			std::smatch m;
 
-			// Convert something like "B6" to the coordinate value 2 * boardSize + 6, and return -1 if this was not possible
+			// Convert something like "B6" to the coordinate value 6 * Size + 1, and return -1 if this was not possible
 			static const auto parseCoordinate = [] (const auto & s0, const auto & s1) {
 				assert(s0.size() == 1);
 				assert(s1.size() >= 1);
@@ -74,7 +105,7 @@ namespace {
 				} else {
 					col = s0[0] - 'A';
 				}
-				if(!(col >= 0 && col < static_cast<int>(boardSize))) {
+				if(!(col >= 0 && col < static_cast<int>(Size))) {
 					// Didn't work, prompt again.
 					return static_cast<uint32_t>(-1);
 				}
@@ -84,10 +115,10 @@ namespace {
 				} catch(...) {
 					return static_cast<uint32_t>(-1);
 				}
-				if(!(row >= 0 && row < static_cast<int>(boardSize))) {
+				if(!(row >= 0 && row < static_cast<int>(Size))) {
 					return static_cast<uint32_t>(-1);
 				}
-				return static_cast<uint32_t>(row) * boardSize + static_cast<uint32_t>(col);
+				return static_cast<uint32_t>(row) * Size + static_cast<uint32_t>(col);
 			};
 			if(std::regex_match(i, m, spawnRegex) && m.size() == 3) {
 				const auto newBlob = parseCoordinate(m[1].str(), m[2].str());
@@ -95,12 +126,13 @@ namespace {
 					continue;
 				} else {
 					// Spawn a new blob.
-					assert(newBlob < boardSize * boardSize);
-					newStatus.spawn(newBlob / boardSize, newBlob % boardSize);
-					if(std::find(possibleMoves.cbegin(), possibleMoves.cbegin() + numMoves, newStatus) == possibleMoves.cbegin() + numMoves) {
+					assert(newBlob < Size * Size);
+					const auto move = Move::spawn(newBlob);
+					if(std::find(possibleMoves.cbegin(), possibleMoves.cbegin() + numMoves, move) == possibleMoves.cbegin() + numMoves) {
 						std::cout << "Illegal move!\n";
 						continue;
 					} else {
+						newStatus.makeMove(move);
 						break;
 					}
 				}
@@ -111,15 +143,14 @@ namespace {
 						oldBlob == static_cast<uint32_t>(-1)) {
 					continue;
 				} else {
-					assert(oldBlob < boardSize * boardSize);
-					assert(newBlob < boardSize * boardSize);
-					// Remove blob that jumped.
-					newStatus.set(oldBlob);
-					newStatus.spawn(newBlob / boardSize, newBlob % boardSize);
-					if(std::find(possibleMoves.cbegin(), possibleMoves.cbegin() + numMoves, newStatus) == possibleMoves.cbegin() + numMoves) {
+					assert(oldBlob < Size * Size);
+					assert(newBlob < Size * Size);
+					const auto move = Move::jump(oldBlob, newBlob);
+					if(std::find(possibleMoves.cbegin(), possibleMoves.cbegin() + numMoves, move) == possibleMoves.cbegin() + numMoves) {
 						std::cout << "Illegal move!\n";
 						continue;
 					} else {
+						newStatus.makeMove(move);
 						break;
 					}
 				}
@@ -129,65 +160,676 @@ namespace {
 		return std::make_pair(true, newStatus);
 	}
 #endif
-}
 
-int main()
-{
-	using namespace atasol;
-	Status status;
+	//! Parse a positive number below limit given on the command line, returning fallback if it is invalid
+	/*!
+	 * \param[in] zero Whether zero is valid as well, such as for a time meaning no limit
+	 */
+	uint32_t parseNumber(char const * s, const uint32_t fallback, const uint32_t limit, const bool zero = false)
+	{
+		char * end;
+		const auto n = std::strtoul(s, &end, 10);
+		if(*s == '\0' || *end != '\0' || (n == 0 && !zero) || n >= limit) {
+			std::cerr << "Invalid number " << s << ", using " << fallback << '\n';
+			return fallback;
+		}
+		return static_cast<uint32_t>(n);
+	}
 
-	status.set(0 * boardSize + 0, Entry::White);
-	status.set(0 * boardSize + boardSize - 1, Entry::Black);
-	status.set((boardSize - 1) * boardSize + 0, Entry::Black);
-	status.set((boardSize - 1) * boardSize + boardSize - 1, Entry::White);
+	//! The smallest board size that can be chosen at runtime
+	constexpr uint32_t minBoardSize = 4;
 
-	int moveNum = 0;
-		std::cout << status.to_string();
-	for(;;) {
-		if(std::abs(status.score()) >= static_cast<Score>(boardSize * boardSize)) {
-			break;
+	//! The largest board size that can be chosen at runtime, as a board must fit into a Bitboard
+	constexpr uint32_t maxBoardSize = 8;
+
+	//! Call f with std::integral_constant<uint32_t, size>, so that it runs the code compiled for that board size
+	/*!
+	 * \return The return value of f, or 1 if size is not supported
+	 */
+	template<typename F>
+	int withBoardSize(const uint32_t size, F && f)
+	{
+		static_assert(minBoardSize == 4 && maxBoardSize == 8, "Every supported size needs a case.");
+		switch(size) {
+			case 4:
+				return f(std::integral_constant<uint32_t, 4>{});
+			case 5:
+				return f(std::integral_constant<uint32_t, 5>{});
+			case 6:
+				return f(std::integral_constant<uint32_t, 6>{});
+			case 7:
+				return f(std::integral_constant<uint32_t, 7>{});
+			case 8:
+				return f(std::integral_constant<uint32_t, 8>{});
+			default:
+				std::cerr << "Unsupported board size " << size << '\n';
+				return 1;
 		}
-		std::cout << "======== Move " << moveNum++ << " ========\n";
+	}
 
-#ifdef WHITEHUMAN
+	//! Parse a FEN string, printing an error if it is invalid
+	template<uint32_t Size>
+	bool parseFenArgument(std::string const & fen, atasol::BasicStatus<Size> & status)
+	{
+		if(!atasol::parseFen(fen, status)) {
+			std::cerr << "Invalid FEN " << fen << '\n';
+			return false;
+		}
+		return true;
+	}
+
+	//! Load the Network of a file unless path is empty, printing why it cannot be loaded
+	template<uint32_t Size>
+	bool loadNetwork(std::string const & path, atasol::Network<Size> & network)
+	{
+		if(!path.empty() && !network.open(path)) {
+			std::cerr << "Cannot open network " << path << " for a " << Size << 'x' << Size << " board\n";
+			return false;
+		}
+		return true;
+	}
+
+	//! Compare the time to reach a depth of a single Searcher and a ParallelSearcher on a few positions
+	/*!
+	 * The positions are first and two statuses reached from it by quick searches.
+	 * Every position is also searched for three ranked lines, the best of which has to match a search without reductions.
+	 * \return Nonzero if it does not for any position
+	 */
+	template<uint32_t Size>
+	int bench(atasol::BasicStatus<Size> const & first, const uint32_t depth, const uint32_t threads, const std::size_t hashMegabytes,
+			std::string const & networkPath)
+	{
+		using namespace atasol;
+		Network<Size> network;
+		if(!loadNetwork(networkPath, network)) {
+			return 1;
+		}
+		const auto evaluator = network.isOpen() ? &network : nullptr;
+		std::vector<BasicStatus<Size>> positions;
 		{
-			auto s = getHumanInput(status);
-			if(!s.first) {
-				break;
+			auto status = first;
+			BasicSearcher<Size> searcher;
+			SearchLimits limits;
+			limits.depth = 3;
+			for(uint32_t ply = 0; ply != 17 && !status.gameOver(); ++ply) {
+				if(ply % 8 == 0) {
+					positions.push_back(status);
+				}
+				status.play(searcher.search(status, limits).move);
 			}
-			status = std::move(s.second);
 		}
-#else
-		{
-			Status newStatus;
-			minimax<WHITEDEPTH>(status, &newStatus);
-			std::cout << "> " << moveString(status, newStatus) << '\n';
-			status = std::move(newStatus);
+
+		SearchLimits limits;
+		limits.depth = depth;
+		SearchLimits exactLimits = limits;
+		exactLimits.reductions = false;
+		SearchLimits rankedLimits = limits;
+		rankedLimits.multiPv = 3;
+		bool consistent = true;
+		double singleTime = 0;
+		double parallelTime = 0;
+		for(auto const & status : positions) {
+			TranspositionTable singleTable(hashMegabytes);
+			BasicSearcher<Size> single(&singleTable, 0, nullptr, evaluator);
+			TranspositionTable parallelTable(hashMegabytes);
+			BasicParallelSearcher<Size> parallel(&parallelTable, threads, nullptr, evaluator);
+
+			auto start = std::chrono::steady_clock::now();
+			const auto singleResult = single.search(status, limits);
+			const std::chrono::duration<double> singleDuration = std::chrono::steady_clock::now() - start;
+			start = std::chrono::steady_clock::now();
+			const auto parallelResult = parallel.search(status, limits);
+			const std::chrono::duration<double> parallelDuration = std::chrono::steady_clock::now() - start;
+
+			std::cout << status.to_string();
+			std::cout << "1 thread: " << moveString<Size>(singleResult.move) << " score " << singleResult.score
+				<< ", " << singleResult.nodes << " nodes in " << singleDuration.count() << " s, "
+				<< static_cast<uint64_t>(static_cast<double>(singleResult.nodes) / singleDuration.count()) << " nodes/s\n";
+			std::cout << "  " << singleResult.stats.evaluations << " evaluations, " << singleResult.stats.cutoffs << " cutoffs, "
+				<< 100 * singleResult.stats.firstMoveCutoffRate() << " % by the first move, "
+				<< 100 * singleResult.stats.tableHitRate() << " % table hits, branching factor " << singleResult.stats.branchingFactor() << '\n';
+			std::cout << threads << " threads: " << moveString<Size>(parallelResult.move) << " score " << parallelResult.score
+				<< ", " << parallelResult.nodes << " nodes in " << parallelDuration.count() << " s, "
+				<< static_cast<uint64_t>(static_cast<double>(parallelResult.nodes) / parallelDuration.count()) << " nodes/s\n\n";
+			singleTime += singleDuration.count();
+			parallelTime += parallelDuration.count();
+
+			// The best of several ranked lines has to be what a single line search without reductions finds.
+			TranspositionTable exactTable(hashMegabytes);
+			const auto exactResult = BasicSearcher<Size>(&exactTable, 0, nullptr, evaluator).search(status, exactLimits);
+			TranspositionTable rankedTable(hashMegabytes);
+			const auto rankedResult = BasicSearcher<Size>(&rankedTable, 0, nullptr, evaluator).search(status, rankedLimits);
+			const bool sameBest = !rankedResult.lines.empty() && rankedResult.lines.front().score == exactResult.score
+				&& std::any_of(rankedResult.lines.begin(), rankedResult.lines.end(), [&exactResult] (SearchLine const & line) {
+					return line.move == exactResult.move && line.score == exactResult.score;
+				});
+			if(!sameBest && !(rankedResult.lines.empty() && exactResult.move.isPass())) {
+				std::cout << "MultiPV mismatch: " << moveString<Size>(exactResult.move) << " score " << exactResult.score << " without reductions, but "
+					<< (rankedResult.lines.empty() ? std::string("no lines") : moveString<Size>(rankedResult.lines.front().move) + " score "
+					+ std::to_string(rankedResult.lines.front().score)) << " as the best of " << rankedLimits.multiPv << " lines\n\n";
+				consistent = false;
+			}
 		}
-#endif
+		std::cout << "Speed-up to depth " << depth << " with " << threads << " threads: " << singleTime / parallelTime << '\n';
+		return consistent ? 0 : 1;
+	}
+
+	//! Run perft() to increasing depths, printing the number of nodes and the speed
+	template<uint32_t Size>
+	int perftDepths(atasol::BasicStatus<Size> status, const uint32_t depth)
+	{
+		using namespace atasol;
 		std::cout << status.to_string();
-		if(std::abs(status.score()) >= static_cast<Score>(boardSize * boardSize)) {
-			break;
+		for(uint32_t d = 1; d <= depth; ++d) {
+			const auto start = std::chrono::steady_clock::now();
+			const auto nodes = perft(status, d);
+			const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+			std::cout << "perft " << d << ": " << nodes << " nodes in " << duration.count() << " s, "
+				<< static_cast<uint64_t>(static_cast<double>(nodes) / duration.count()) << " nodes/s\n";
 		}
+		return 0;
+	}
 
-#ifdef BLACKHUMAN
-		{
-			auto s = getHumanInput(status);
-			if(!s.first) {
-				break;
+	//! Check perft() against all perftReferences, returning nonzero on a mismatch
+	int perftSuite()
+	{
+		using namespace atasol;
+		uint64_t totalNodes = 0;
+		double totalTime = 0;
+		bool ok = true;
+		for(auto const & reference : perftReferences) {
+			const auto mismatch = withBoardSize(fenBoardSize(reference.fen), [&] (auto size) {
+				BasicStatus<decltype(size)::value> status;
+				if(!parseFenArgument(reference.fen, status)) {
+					return 1;
+				}
+				int r = 0;
+				for(uint32_t d = 1; d <= reference.depth; ++d) {
+					const auto start = std::chrono::steady_clock::now();
+					const auto nodes = perft(status, d);
+					const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+					totalNodes += nodes;
+					totalTime += duration.count();
+					if(nodes != reference.nodes[d - 1]) {
+						std::cout << reference.fen << " depth " << d << ": " << nodes << " nodes, expected " << reference.nodes[d - 1] << '\n';
+						r = 1;
+					}
+				}
+				const auto asymmetric = asymmetricEvaluations(status, std::min(reference.depth, 3U));
+				if(asymmetric != 0) {
+					std::cout << reference.fen << ": " << asymmetric << " statuses evaluate differently under a symmetry\n";
+					r = 1;
+				}
+				return r;
+			});
+			if(mismatch != 0) {
+				ok = false;
 			}
-			status = std::move(s.second);
 		}
-#else
-		{
-			Status newStatus;
-			minimax<BLACKDEPTH>(status, &newStatus);
-			std::cout << "> " << moveString(status, newStatus) << '\n';
-			status = std::move(newStatus);
+		std::cout << (ok ? "All perft results match" : "Perft results differ") << ", "
+			<< totalNodes << " nodes in " << totalTime << " s, "
+			<< static_cast<uint64_t>(static_cast<double>(totalNodes) / totalTime) << " nodes/s\n";
+		return ok ? 0 : 1;
+	}
+
+	//! Generate the Tablebase of a board size, printing what was found
+	template<uint32_t Size>
+	int generateTablebase(std::string const & path, const uint32_t threads)
+	{
+		using namespace atasol;
+		if(!Tablebase<Size>::supported) {
+			std::cerr << "Tablebases are only supported for boards of up to 16 fields\n";
+			return 1;
 		}
-#endif
+		TablebaseCounts counts;
+		const auto start = std::chrono::steady_clock::now();
+		if(!Tablebase<Size>::generate(path, threads, counts)) {
+			std::cerr << "Cannot write tablebase " << path << '\n';
+			return 1;
+		}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		std::cout << Size << 'x' << Size << " tablebase with " << Tablebase<Size>::positions << " statuses written to " << path
+			<< " after " << counts.sweeps << " sweeps in " << duration.count() << " s: "
+			<< counts.wins << " wins, " << counts.losses << " losses, " << counts.draws << " draws\n";
+		return 0;
+	}
+
+	//! Build the OpeningBook of a start Status, printing how many statuses it has
+	template<uint32_t Size>
+	int buildBook(atasol::BasicStatus<Size> const & start, std::string const & path, const uint32_t plies, const uint32_t depth,
+			const uint32_t threads, const std::size_t hashMegabytes)
+	{
+		using namespace atasol;
+		SearchLimits limits;
+		limits.depth = depth;
+		std::size_t entries = 0;
+		const auto begin = std::chrono::steady_clock::now();
+		if(!OpeningBook<Size>::build(start, plies, limits, threads, hashMegabytes, path, entries)) {
+			std::cerr << "Cannot write book " << path << '\n';
+			return 1;
+		}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+		std::cout << "Book of the first " << plies << " moves searched to depth " << depth << " with " << entries
+			<< " statuses written to " << path << " in " << duration.count() << " s\n";
+		return 0;
+	}
+
+	//! Make the move of a computer player, taking it from the book if the status is in it
+	template<uint32_t Size>
+	void computerMove(atasol::BasicStatus<Size> & status, atasol::BasicParallelSearcher<Size> & searcher, atasol::OpeningBook<Size> const & book,
+			atasol::SearchLimits const & limits)
+	{
+		using namespace atasol;
+		BookEntry entry;
+		if(book.probe(status, entry)) {
+			std::cout << "> " << moveString<Size>(entry.move) << " (book)\n";
+			status.play(entry.move);
+			return;
+		}
+		const auto result = searcher.search(status, limits);
+		std::cout << "> " << moveString<Size>(result.move) << '\n';
+		status.play(result.move);
+	}
+
+	//! Play self-play games from a start Status, printing how many statuses were written
+	template<uint32_t Size>
+	int selfPlay(atasol::BasicStatus<Size> const & start, std::string const & path, const uint64_t games, const uint32_t depth, const uint32_t openingPlies,
+			const uint32_t threads, const std::size_t hashMegabytes, std::string const & networkPath)
+	{
+		using namespace atasol;
+		Network<Size> network;
+		if(!loadNetwork(networkPath, network)) {
+			return 1;
+		}
+		SearchLimits limits;
+		limits.depth = depth;
+		SelfPlayCounts counts;
+		const auto begin = std::chrono::steady_clock::now();
+		if(!SelfPlayFile<Size>::generate(start, games, openingPlies, limits, threads, hashMegabytes, path, counts, 0, network.isOpen() ? &network : nullptr)) {
+			std::cerr << "Cannot write " << path << '\n';
+			return 1;
+		}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+		std::cout << counts.games << " games with " << counts.positions << " statuses written to " << path << " in " << duration.count() << " s, "
+			<< static_cast<uint64_t>(static_cast<double>(counts.positions) / duration.count()) << " statuses/s: "
+			<< counts.whiteWins << " white wins, " << counts.blackWins << " black wins, " << counts.draws << " draws, "
+			<< counts.cutOff << " of them cut off\n";
+		return 0;
+	}
+
+	//! Analyse the FEN lines of a file, or of standard input if path is "-", writing JSON lines to standard output
+	template<uint32_t Size>
+	int analyseFile(std::string const & path, atasol::SearchLimits const & limits, const uint32_t threads, const std::size_t hashMegabytes,
+			std::string const & tablebasePath, std::string const & networkPath)
+	{
+		using namespace atasol;
+		Tablebase<Size> tablebase;
+		if(!tablebasePath.empty() && !tablebase.open(tablebasePath)) {
+			std::cerr << "Cannot open tablebase " << tablebasePath << " for a " << Size << 'x' << Size << " board\n";
+			return 1;
+		}
+		Network<Size> network;
+		if(!loadNetwork(networkPath, network)) {
+			return 1;
+		}
+		std::ifstream file;
+		if(path != "-") {
+			file.open(path);
+			if(!file) {
+				std::cerr << "Cannot open " << path << '\n';
+				return 1;
+			}
+		}
+		const bool valid = analyse<Size>(path == "-" ? std::cin : file, std::cout, limits, threads, hashMegabytes,
+				tablebase.isOpen() ? &tablebase : nullptr, network.isOpen() ? &network : nullptr);
+		return valid ? 0 : 1;
+	}
+
+	//! Speak the Universal Ataxx Interface on standard input and output until quit
+	template<uint32_t Size>
+	int uai(const uint32_t threads, const std::size_t hashMegabytes, std::string const & tablebasePath, std::string const & bookPath,
+			std::string const & networkPath)
+	{
+		using namespace atasol;
+		Tablebase<Size> tablebase;
+		if(!tablebasePath.empty() && !tablebase.open(tablebasePath)) {
+			std::cerr << "Cannot open tablebase " << tablebasePath << " for a " << Size << 'x' << Size << " board\n";
+			return 1;
+		}
+		OpeningBook<Size> book;
+		if(!bookPath.empty() && !book.open(bookPath)) {
+			std::cerr << "Cannot open book " << bookPath << " for a " << Size << 'x' << Size << " board\n";
+			return 1;
+		}
+		Network<Size> network;
+		if(!loadNetwork(networkPath, network)) {
+			return 1;
+		}
+		UaiEngine<Size> engine(std::cout, hashMegabytes, threads, tablebase.isOpen() ? &tablebase : nullptr, network.isOpen() ? &network : nullptr,
+				book.isOpen() ? &book : nullptr);
+		std::string line;
+		while(std::getline(std::cin, line) && engine.command(line)) {
+		}
+		return 0;
+	}
+
+	//! Parse a player of a match, printing why it is invalid
+	/*!
+	 * The player is a comma separated list of depth=N, nodes=N and ms=N limiting every search, clock=N and inc=N
+	 * for a clock of N milliseconds per game and N more after every move, network to evaluate with the network of --network,
+	 * and mcts to search with Monte Carlo tree search, such as "depth=6" or "clock=10000,inc=100,mcts".
+	 * Monte Carlo tree search plays random games instead of evaluating, so network and mcts do not go together,
+	 * and it has no depth to limit, so neither do depth and mcts. Without nodes, ms or clock, mcts runs BasicMctsSearcher::defaultPlayouts.
+	 * Without depth, searches stop only at the other limits, if any.
+	 */
+	template<uint32_t Size>
+	bool parseMatchPlayer(std::string const & spec, atasol::Network<Size> const & network, atasol::MatchPlayer<Size> & player)
+	{
+		using namespace atasol;
+		player = MatchPlayer<Size>();
+		bool depthGiven = false;
+		std::istringstream in(spec);
+		std::string token;
+		while(std::getline(in, token, ',')) {
+			const auto equals = token.find('=');
+			const auto name = token.substr(0, equals);
+			char * end = nullptr;
+			const auto value = equals == std::string::npos ? 0 : std::strtoull(token.c_str() + equals + 1, &end, 10);
+			const bool valid = equals != std::string::npos && *end == '\0' && value != 0;
+			if(name == "depth" && valid && value < maxDepth) {
+				player.limits.depth = static_cast<uint32_t>(value);
+				depthGiven = true;
+			} else if(name == "nodes" && valid) {
+				player.limits.nodes = value;
+			} else if(name == "ms" && valid) {
+				player.limits.time = std::chrono::milliseconds(value);
+			} else if(name == "clock" && valid) {
+				player.clock = std::chrono::milliseconds(value);
+			} else if(name == "inc" && valid) {
+				player.increment = std::chrono::milliseconds(value);
+			} else if(token == "network" && network.isOpen()) {
+				player.network = &network;
+			} else if(token == "mcts") {
+				player.mcts = true;
+			} else {
+				std::cerr << "Invalid player " << spec << " at " << token << '\n';
+				return false;
+			}
+		}
+		if(player.mcts && player.network != nullptr) {
+			std::cerr << "Invalid player " << spec << ", mcts does not evaluate with a network\n";
+			return false;
+		}
+		if(player.mcts && depthGiven) {
+			std::cerr << "Invalid player " << spec << ", mcts does not search to a depth\n";
+			return false;
+		}
+		if(!depthGiven && (player.limits.nodes != 0 || player.limits.time != std::chrono::steady_clock::duration::zero()
+					|| player.clock != std::chrono::steady_clock::duration::zero())) {
+			player.limits.depth = maxDepth - 1;
+		}
+		return true;
+	}
+
+	//! Print the results of a match so far on one line
+	void printMatchCounts(atasol::MatchCounts const & counts, atasol::Sprt const * sprt)
+	{
+		std::cout << "Games " << counts.games() << ": " << counts.wins << " wins, " << counts.draws << " draws, " << counts.losses << " losses, Elo "
+			<< std::fixed << std::setprecision(1) << counts.elo() << " +- " << counts.eloError();
+		if(counts.timeouts != 0) {
+			std::cout << ", " << counts.timeouts << " lost on time";
+		}
+		if(sprt != nullptr) {
+			std::cout << std::setprecision(2) << ", LLR " << counts.llr(*sprt) << " (" << sprt->lowerBound() << ", " << sprt->upperBound() << ')';
+		}
+		std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+	}
+
+	//! Play a match between two computer players from the openings of a file, or random ones if path is "-"
+	template<uint32_t Size>
+	int match(atasol::BasicStatus<Size> const & start, const uint64_t games, std::string const & firstSpec, std::string const & secondSpec,
+			std::string const & openingsPath, atasol::Sprt const * sprt, const uint32_t threads, const std::size_t hashMegabytes, std::string const & networkPath)
+	{
+		using namespace atasol;
+		Network<Size> network;
+		if(!loadNetwork(networkPath, network)) {
+			return 1;
+		}
+		MatchPlayer<Size> first;
+		MatchPlayer<Size> second;
+		if(!parseMatchPlayer(firstSpec, network, first) || !parseMatchPlayer(secondSpec, network, second)) {
+			return 1;
+		}
+		std::vector<BasicStatus<Size>> openings;
+		if(openingsPath == "-") {
+			openings = randomOpenings(start, (games + 1) / 2, 4);
+		} else {
+			std::ifstream file(openingsPath);
+			if(!file) {
+				std::cerr << "Cannot open " << openingsPath << '\n';
+				return 1;
+			}
+			std::string line;
+			while(std::getline(file, line)) {
+				if(line.empty()) {
+					continue;
+				}
+				BasicStatus<Size> status;
+				if(fenBoardSize(line) != Size || !parseFenArgument(line, status)) {
+					return 1;
+				}
+				openings.push_back(status);
+			}
+			if(openings.empty()) {
+				std::cerr << "No openings in " << openingsPath << '\n';
+				return 1;
+			}
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		const auto counts = playMatch(openings, games, first, second, threads, hashMegabytes, sprt, [sprt] (MatchCounts const & c) {
+			if(c.games() % 100 == 0) {
+				printMatchCounts(c, sprt);
+			}
+		});
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+		if(counts.games() % 100 != 0) {
+			printMatchCounts(counts, sprt);
+		}
+		if(sprt != nullptr) {
+			const auto llr = counts.llr(*sprt);
+			std::cout << (llr >= sprt->upperBound() ? "Elo1 accepted" : llr <= sprt->lowerBound() ? "Elo0 accepted" : "No decision") << " after ";
+		}
+		std::cout << counts.games() << " games in " << duration.count() << " s\n";
+		return 0;
+	}
+
+	//! Play a game from a Status between two computer players or humans
+	template<uint32_t Size>
+	int play(atasol::BasicStatus<Size> status, atasol::SearchLimits const & whiteLimits, atasol::SearchLimits const & blackLimits, const uint32_t threads, const std::size_t hashMegabytes,
+			std::string const & tablebasePath, std::string const & bookPath, std::string const & networkPath)
+	{
+		using namespace atasol;
+		Tablebase<Size> tablebase;
+		if(!tablebasePath.empty() && !tablebase.open(tablebasePath)) {
+			std::cerr << "Cannot open tablebase " << tablebasePath << " for a " << Size << 'x' << Size << " board\n";
+			return 1;
+		}
+		OpeningBook<Size> book;
+		if(!bookPath.empty() && !book.open(bookPath)) {
+			std::cerr << "Cannot open book " << bookPath << " for a " << Size << 'x' << Size << " board\n";
+			return 1;
+		}
+		TranspositionTable table(hashMegabytes);
+		Network<Size> network;
+		if(!loadNetwork(networkPath, network)) {
+			return 1;
+		}
+		BasicParallelSearcher<Size> searcher(&table, threads, tablebase.isOpen() ? &tablebase : nullptr, network.isOpen() ? &network : nullptr);
+		// Only one of them is used if the other player is a human.
+		(void) whiteLimits;
+		(void) blackLimits;
+
+		int moveNum = 0;
 		std::cout << status.to_string();
+		for(;;) {
+			if(status.gameOver()) {
+				break;
+			}
+			std::cout << "======== Move " << moveNum++ << " ========\n";
+
+			if(status.whiteMoves()) {
+#ifdef WHITEHUMAN
+				auto s = getHumanInput(status);
+				if(!s.first) {
+					break;
+				}
+				status = std::move(s.second);
+#else
+				computerMove(status, searcher, book, whiteLimits);
+#endif
+			} else {
+#ifdef BLACKHUMAN
+				auto s = getHumanInput(status);
+				if(!s.first) {
+					break;
+				}
+				status = std::move(s.second);
+#else
+				computerMove(status, searcher, book, blackLimits);
+#endif
+			}
+			std::cout << status.to_string();
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace atasol;
+	uint32_t threads = THREADS;
+	std::size_t hashMegabytes = HASHMEGABYTES;
+	uint32_t size = boardSize;
+	std::string startFen;
+	std::string tablebasePath;
+	std::string networkPath;
+	std::string bookPath;
+	std::vector<std::string> args;
+	for(int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if(arg == "--threads" && i + 1 < argc) {
+			threads = parseNumber(argv[++i], threads, 1024);
+		} else if(arg == "--hash" && i + 1 < argc) {
+			hashMegabytes = parseNumber(argv[++i], HASHMEGABYTES, 1 << 20);
+		} else if(arg == "--size" && i + 1 < argc) {
+			size = parseNumber(argv[++i], boardSize, maxBoardSize + 1);
+		} else if(arg == "--book" && i + 1 < argc) {
+			bookPath = argv[++i];
+		} else if(arg == "--tablebase" && i + 1 < argc) {
+			tablebasePath = argv[++i];
+		} else if(arg == "--network" && i + 1 < argc) {
+			networkPath = argv[++i];
+		} else if(arg == "--fen" && i + 1 < argc) {
+			startFen = argv[++i];
+			size = fenBoardSize(startFen);
+		} else {
+			args.push_back(arg);
+		}
 	}
 
-	return 0;
+	if(!args.empty() && args[0] == "perft") {
+		if(args.size() > 1 && args[1] == "suite") {
+			return perftSuite();
+		}
+		if(args.size() > 2) {
+			startFen.clear();
+			for(std::size_t i = 2; i != args.size(); ++i) {
+				startFen += (i == 2 ? "" : " ") + args[i];
+			}
+			size = fenBoardSize(startFen);
+		}
+	}
+
+	// Everything else works on the board size given by --size or the FEN.
+	return withBoardSize(size, [&] (auto boardSizeConstant) {
+		constexpr uint32_t Size = decltype(boardSizeConstant)::value;
+		auto status = startingStatus<Size>();
+		if(!startFen.empty() && !parseFenArgument(startFen, status)) {
+			return 1;
+		}
+
+		if(!args.empty() && args[0] == "perft") {
+			return perftDepths(status, args.size() > 1 ? parseNumber(args[1].c_str(), 5, maxDepth) : 5);
+		}
+
+		if(args.size() > 1 && args[0] == "network") {
+			if(!Network<Size>::writeMaterial(args[1])) {
+				std::cerr << "Cannot write network " << args[1] << '\n';
+				return 1;
+			}
+			std::cout << "Network counting material on a " << Size << 'x' << Size << " board written to " << args[1] << '\n';
+			return 0;
+		}
+
+		if(args.size() > 1 && args[0] == "tablebase") {
+			return generateTablebase<Size>(args[1], args.size() > 2 ? parseNumber(args[2].c_str(), threads, 1024) : threads);
+		}
+
+		if(args.size() > 1 && args[0] == "book") {
+			return buildBook(status, args[1],
+					args.size() > 2 ? parseNumber(args[2].c_str(), 4, maxDepth) : 4,
+					args.size() > 3 ? parseNumber(args[3].c_str(), 9, maxDepth) : 9,
+					threads, hashMegabytes);
+		}
+
+		if(args.size() > 1 && args[0] == "selfplay") {
+			return selfPlay(status, args[1],
+					args.size() > 2 ? parseNumber(args[2].c_str(), 100, UINT32_MAX) : 100,
+					args.size() > 3 ? parseNumber(args[3].c_str(), 5, maxDepth) : 5,
+					args.size() > 4 ? parseNumber(args[4].c_str(), 4, maxDepth) : 4,
+					threads, hashMegabytes, networkPath);
+		}
+
+		if(!args.empty() && args[0] == "analyse") {
+			SearchLimits limits;
+			limits.depth = args.size() > 2 ? parseNumber(args[2].c_str(), 9, maxDepth) : 9;
+			limits.time = std::chrono::milliseconds(args.size() > 3 ? parseNumber(args[3].c_str(), 0, 1U << 31, true) : 0);
+			limits.multiPv = args.size() > 4 ? parseNumber(args[4].c_str(), 1, UINT32_MAX) : 1;
+			return analyseFile<Size>(args.size() > 1 ? args[1] : "-", limits, threads, hashMegabytes, tablebasePath, networkPath);
+		}
+
+		if(!args.empty() && args[0] == "uai") {
+			return uai<Size>(threads, hashMegabytes, tablebasePath, bookPath, networkPath);
+		}
+
+		if(args.size() > 3 && args[0] == "match") {
+			Sprt sprt;
+			if(args.size() > 6) {
+				char * end0;
+				char * end1;
+				sprt.elo0 = std::strtod(args[5].c_str(), &end0);
+				sprt.elo1 = std::strtod(args[6].c_str(), &end1);
+				if(args[5].empty() || args[6].empty() || *end0 != '\0' || *end1 != '\0' || !sprt.valid()) {
+					std::cerr << "Invalid Elo differences " << args[5] << " and " << args[6] << ", elo1 must be above elo0\n";
+					return 1;
+				}
+			}
+			return match(status, parseNumber(args[1].c_str(), 1000, UINT32_MAX), args[2], args[3], args.size() > 4 ? args[4] : "-",
+					args.size() > 6 ? &sprt : nullptr, threads, hashMegabytes, networkPath);
+		}
+
+		if(!args.empty() && args[0] == "bench") {
+			return bench(status, args.size() > 1 ? parseNumber(args[1].c_str(), 7, maxDepth) : 7,
+					args.size() > 2 ? parseNumber(args[2].c_str(), threads, 1024) : threads,
+					hashMegabytes, networkPath);
+		}
+
+		SearchLimits whiteLimits;
+		whiteLimits.depth = args.size() > 0 ? parseNumber(args[0].c_str(), WHITEDEPTH, maxDepth) : WHITEDEPTH;
+		SearchLimits blackLimits;
+		blackLimits.depth = args.size() > 1 ? parseNumber(args[1].c_str(), BLACKDEPTH, maxDepth) : BLACKDEPTH;
+		return play(status, whiteLimits, blackLimits, threads, hashMegabytes, tablebasePath, bookPath, networkPath);
+	});
 }
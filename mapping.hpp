@@ -0,0 +1,110 @@
+/*!
+ * \file atasol_mapping.hpp
+ * \brief atasol read-only memory mapped files
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_MAPPING_HPP_
+#define ATASOL_MAPPING_HPP_
+
+#include <cstddef>
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace atasol {
+	//! A whole file mapped into memory read-only, so that only the parts that are accessed are ever loaded
+	class MappedFile
+	{
+		public:
+			MappedFile() = default;
+			MappedFile(MappedFile const &) = delete;
+			MappedFile & operator=(MappedFile const &) = delete;
+
+			~MappedFile()
+			{
+				close();
+			}
+
+			//! Map a file, replacing any file mapped before
+			/*!
+			 * \return Whether the file could be mapped, which empty files cannot
+			 */
+			bool open(std::string const & path)
+			{
+				close();
+				const int fd = ::open(path.c_str(), O_RDONLY);
+				if(fd < 0) {
+					return false;
+				}
+				struct stat info;
+				if(::fstat(fd, &info) != 0 || info.st_size <= 0) {
+					::close(fd);
+					return false;
+				}
+				const auto size = static_cast<std::size_t>(info.st_size);
+				void * p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+				::close(fd);
+				if(p == MAP_FAILED) {
+					return false;
+				}
+				data_ = static_cast<unsigned char const *>(p);
+				size_ = size;
+				return true;
+			}
+
+			//! Unmap the file, if one is mapped
+			void close() noexcept
+			{
+				if(data_ != nullptr) {
+					::munmap(const_cast<unsigned char *>(data_), size_);
+					data_ = nullptr;
+					size_ = 0;
+				}
+			}
+
+			//! The contents of the file, or nullptr if none is mapped
+			unsigned char const * data() const noexcept
+			{
+				return data_;
+			}
+
+			//! The size of the file in bytes
+			std::size_t size() const noexcept
+			{
+				return size_;
+			}
+
+		private:
+			unsigned char const * data_ = nullptr;
+			std::size_t size_ = 0;
+	};
+}
+
+#endif
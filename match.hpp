@@ -0,0 +1,364 @@
+/*!
+ * \file atasol_match.hpp
+ * \brief atasol engine matches
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_MATCH_HPP_
+#define ATASOL_MATCH_HPP_
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "mcts.hpp"
+#include "nnue.hpp"
+#include "search.hpp"
+#include "selfplay.hpp"
+#include "solver.hpp"
+
+namespace atasol {
+	//! How one player of a match searches
+	template<uint32_t Size>
+		struct MatchPlayer
+		{
+			//! The limits of every search, of which depth, nodes and time apply
+			SearchLimits limits;
+
+			//! The Network that evaluates for this player, or nullptr
+			Network<Size> const * network = nullptr;
+
+			//! Whether the player searches with BasicMctsSearcher instead of BasicSearcher
+			bool mcts = false;
+
+			//! The time on the clock of the player at the start of a game, or zero to play without clock
+			/*!
+			 * With a clock, the time limits of every search are set by budgetTime(), and a player running out of time loses.
+			 */
+			std::chrono::steady_clock::duration clock = std::chrono::steady_clock::duration::zero();
+
+			//! The time added to the clock after every move
+			std::chrono::steady_clock::duration increment = std::chrono::steady_clock::duration::zero();
+		};
+
+	//! The hypotheses of a sequential probability ratio test about the Elo difference of two players
+	/*!
+	 * The test accepts that the first player is elo1 stronger than the second or that it is only elo0 stronger,
+	 * accepting the wrong one with probabilities of at most alpha and beta respectively.
+	 */
+	struct Sprt
+	{
+		double elo0 = 0;
+		double elo1 = 5;
+		double alpha = 0.05;
+		double beta = 0.05;
+
+		//! Whether elo1 is above elo0 and the error probabilities leave room for both hypotheses to be accepted
+		bool valid() const noexcept
+		{
+			return std::isfinite(elo0) && std::isfinite(elo1) && elo0 < elo1 && alpha > 0 && beta > 0 && alpha + beta < 1;
+		}
+
+		//! The log-likelihood ratio below which elo0 is accepted
+		double lowerBound() const noexcept
+		{
+			return std::log(beta / (1 - alpha));
+		}
+
+		//! The log-likelihood ratio above which elo1 is accepted
+		double upperBound() const noexcept
+		{
+			return std::log((1 - beta) / alpha);
+		}
+	};
+
+	//! The results of the games of a match so far, from the point of view of the first player
+	struct MatchCounts
+	{
+		uint64_t wins = 0;
+		uint64_t draws = 0;
+		uint64_t losses = 0;
+
+		//! The games lost by either player because its clock ran out
+		uint64_t timeouts = 0;
+
+		//! The finished pairs of games from the same opening, counted by the points of the first player in both games, from none to two in steps of a half
+		std::array<uint64_t, 5> pairs{{}};
+
+		uint64_t pairCount() const noexcept
+		{
+			uint64_t r = 0;
+			for(const auto n : pairs) {
+				r += n;
+			}
+			return r;
+		}
+
+		uint64_t games() const noexcept
+		{
+			return wins + draws + losses;
+		}
+
+		//! The mean result of a game, a win counting one and a draw a half
+		double score() const noexcept
+		{
+			return games() == 0 ? 0.5 : (static_cast<double>(wins) + static_cast<double>(draws) / 2) / static_cast<double>(games());
+		}
+
+		//! The Elo difference that the score() corresponds to, which is infinite if one player won every game
+		double elo() const noexcept
+		{
+			return eloOf(score());
+		}
+
+		//! Half the width of the 95% confidence interval of elo()
+		double eloError() const noexcept
+		{
+			const auto error = 1.959964 * std::sqrt(variance() / static_cast<double>(std::max<uint64_t>(games(), 1)));
+			return (eloOf(std::min(score() + error, 1.0)) - eloOf(std::max(score() - error, 0.0))) / 2;
+		}
+
+		//! The log-likelihood ratio of the hypotheses of an Sprt, approximating the results by a normal distribution
+		double llr(Sprt const & sprt) const noexcept
+		{
+			const auto v = variance();
+			if(v == 0) {
+				return 0;
+			}
+			const auto s0 = scoreOf(sprt.elo0);
+			const auto s1 = scoreOf(sprt.elo1);
+			return (s1 - s0) * (2 * score() - s0 - s1) * static_cast<double>(games()) / (2 * v);
+		}
+
+		//! Whether the test has accepted one of its hypotheses
+		bool decided(Sprt const & sprt) const noexcept
+		{
+			const auto r = llr(sprt);
+			return r <= sprt.lowerBound() || r >= sprt.upperBound();
+		}
+
+		//! The variance of the result of a single game
+		/*!
+		 * The two games of an opening are not independent, since the opening may favour one colour,
+		 * so once pairs have finished, the variance is that of the mean result of a pair, which stands for two games.
+		 * Before, the games are taken as independent.
+		 */
+		double variance() const noexcept
+		{
+			const auto n = pairCount();
+			if(n != 0) {
+				double mean = 0;
+				for(uint32_t k = 0; k != pairs.size(); ++k) {
+					mean += static_cast<double>(pairs[k]) * k / 4;
+				}
+				mean /= static_cast<double>(n);
+				double v = 0;
+				for(uint32_t k = 0; k != pairs.size(); ++k) {
+					v += static_cast<double>(pairs[k]) * (k / 4.0 - mean) * (k / 4.0 - mean);
+				}
+				return 2 * v / static_cast<double>(n);
+			}
+			if(games() == 0) {
+				return 0;
+			}
+			const auto s = score();
+			return (static_cast<double>(wins) * (1 - s) * (1 - s) + static_cast<double>(draws) * (0.5 - s) * (0.5 - s)
+					+ static_cast<double>(losses) * s * s) / static_cast<double>(games());
+		}
+
+		static double eloOf(const double score) noexcept
+		{
+			if(score <= 0 || score >= 1) {
+				return score <= 0 ? - std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+			}
+			return -400 * std::log10(1 / score - 1);
+		}
+
+		static double scoreOf(const double elo) noexcept
+		{
+			return 1 / (1 + std::pow(10.0, - elo / 400));
+		}
+	};
+
+	//! Play games between two players, each on a single thread, with many games at once
+	/*!
+	 * Every opening is played twice, the first player having white in the first game and black in the second.
+	 * Games stop after SelfPlayFile<Size>::maxPlies moves at the latest, and are won by whoever has more blobs at the end,
+	 * unless a player with a clock runs out of time before.
+	 * Each worker thread has one TranspositionTable per player, which is cleared before every game.
+	 * \param[in] openings The statuses the games start from, cycled through as long as games remain
+	 * \param[in] games The number of games to play, which is rounded up to an even number
+	 * \param[in] first The player whose point of view the result takes
+	 * \param[in] second The opponent
+	 * \param[in] threads The number of games played at once
+	 * \param[in] hashMegabytes The size of all TranspositionTable objects together, or node pools of MCTS players
+	 * \param[in] sprt If not nullptr, no more games are started or counted once this test accepts one of its hypotheses
+	 * \param[in] progress Called with the results so far after every game, never by two threads at once, if set
+	 * \return The results of all finished games
+	 */
+	template<uint32_t Size>
+		MatchCounts playMatch(std::vector<BasicStatus<Size>> const & openings, const uint64_t games, MatchPlayer<Size> const & first, MatchPlayer<Size> const & second,
+				const uint32_t threads, const std::size_t hashMegabytes, Sprt const * sprt = nullptr,
+				std::function<void(MatchCounts const &)> const & progress = nullptr)
+		{
+			MatchCounts counts;
+			if(openings.empty()) {
+				return counts;
+			}
+			std::mutex countsMutex;
+			std::atomic<uint64_t> nextGame{0};
+			std::atomic<bool> decided{false};
+			// The half points of the first player in games whose other game of the pair has not finished yet, by pair
+			std::map<uint64_t, uint32_t> unpaired;
+			const auto workerCount = std::max(threads, 1U);
+			const auto megabytes = std::max<std::size_t>(hashMegabytes / workerCount / 2, 1);
+			const auto work = [&] {
+				std::array<MatchPlayer<Size> const *, 2> players{{&first, &second}};
+				std::array<std::unique_ptr<TranspositionTable>, 2> tables;
+				std::array<std::unique_ptr<BasicSearcher<Size>>, 2> searchers;
+				std::array<std::unique_ptr<BasicMctsSearcher<Size>>, 2> mcts;
+				for(uint32_t i = 0; i != 2; ++i) {
+					if(players[i]->mcts) {
+						mcts[i].reset(new BasicMctsSearcher<Size>(1, megabytes));
+					} else {
+						tables[i].reset(new TranspositionTable(megabytes));
+						searchers[i].reset(new BasicSearcher<Size>(tables[i].get(), 0, nullptr, players[i]->network));
+					}
+				}
+				for(;;) {
+					const auto game = nextGame.fetch_add(1);
+					if(game >= games + games % 2 || decided.load()) {
+						return;
+					}
+					for(uint32_t i = 0; i != 2; ++i) {
+						if(mcts[i]) {
+							mcts[i]->clear();
+						} else {
+							tables[i]->clear();
+						}
+					}
+					// The first player has white in even games.
+					const auto white = static_cast<uint32_t>(game % 2);
+					auto status = openings[game / 2 % openings.size()];
+					std::array<std::chrono::steady_clock::duration, 2> clocks{{first.clock, second.clock}};
+					uint32_t timeout = 2;
+					for(uint32_t ply = 0; !status.gameOver() && ply != SelfPlayFile<Size>::maxPlies; ++ply) {
+						const auto i = status.whiteMoves() ? white : 1 - white;
+						auto limits = players[i]->limits;
+						const bool clocked = players[i]->clock != std::chrono::steady_clock::duration::zero();
+						if(clocked) {
+							budgetTime(limits, clocks[i], players[i]->increment, 0, detail::popcount(status.empty()));
+						}
+						const auto start = std::chrono::steady_clock::now();
+						const auto result = mcts[i] ? mcts[i]->search(status, limits) : searchers[i]->search(status, limits);
+						if(clocked) {
+							clocks[i] -= std::chrono::steady_clock::now() - start;
+							if(clocks[i] < std::chrono::steady_clock::duration::zero()) {
+								timeout = i;
+								break;
+							}
+							clocks[i] += players[i]->increment;
+						}
+						status.play(result.move);
+					}
+					const auto score = timeout != 2 ? (timeout == 0 ? -1 : 1) : white == 0 ? status.score() : - status.score();
+
+					std::lock_guard<std::mutex> lock(countsMutex);
+					if(decided.load()) {
+						// Games still running when the test decided would only blur its decision.
+						return;
+					}
+					++(score > 0 ? counts.wins : score < 0 ? counts.losses : counts.draws);
+					const auto halves = score > 0 ? 2U : score < 0 ? 0U : 1U;
+					const auto other = unpaired.find(game / 2);
+					if(other == unpaired.end()) {
+						unpaired.emplace(game / 2, halves);
+					} else {
+						++counts.pairs[other->second + halves];
+						unpaired.erase(other);
+					}
+					if(timeout != 2) {
+						++counts.timeouts;
+					}
+					if(sprt != nullptr && counts.decided(*sprt)) {
+						decided.store(true);
+					}
+					if(progress) {
+						progress(counts);
+					}
+				}
+			};
+
+			std::vector<std::thread> workers;
+			for(uint32_t i = 1; i < workerCount; ++i) {
+				workers.emplace_back(work);
+			}
+			work();
+			for(auto & worker : workers) {
+				worker.join();
+			}
+			return counts;
+		}
+
+	//! Statuses reached by random moves from a start Status, for playMatch()
+	/*!
+	 * Random moves that end the game are tried again.
+	 * \param[in] count The number of statuses
+	 * \param[in] plies The number of random moves from start
+	 * \param[in] seed Where the random moves come from
+	 */
+	template<uint32_t Size>
+		std::vector<BasicStatus<Size>> randomOpenings(BasicStatus<Size> const & start, const uint64_t count, const uint32_t plies, const uint64_t seed = 0)
+		{
+			std::vector<BasicStatus<Size>> r;
+			std::mt19937_64 random(seed);
+			std::array<Move, upperLimitMoves<Size>> moves;
+			while(r.size() != count) {
+				auto status = start;
+				for(uint32_t ply = 0; ply != plies && !status.gameOver(); ++ply) {
+					const auto len = generateMoves(status, moves.begin());
+					status.play(len == 0 ? Move::pass() : moves[random() % len]);
+				}
+				if(!status.gameOver() || start.gameOver()) {
+					r.push_back(status);
+				}
+			}
+			return r;
+		}
+}
+
+#endif
@@ -0,0 +1,481 @@
+/*!
+ * \file atasol_mcts.hpp
+ * \brief atasol Monte Carlo tree search
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_MCTS_HPP_
+#define ATASOL_MCTS_HPP_
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "search.hpp"
+#include "solver.hpp"
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace atasol {
+	namespace detail {
+		//! A small and fast random number generator (xorshift64*) for playouts
+		class PlayoutRandom
+		{
+			public:
+				explicit PlayoutRandom(const uint64_t seed) noexcept :
+					state_(seed | 1)
+				{
+				}
+
+				uint64_t next() noexcept
+				{
+					state_ ^= state_ >> 12;
+					state_ ^= state_ << 25;
+					state_ ^= state_ >> 27;
+					return state_ * 0x2545f4914f6cdd1dULL;
+				}
+
+				//! A number below n, which must be positive
+				uint32_t below(const uint32_t n) noexcept
+				{
+					return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+				}
+
+			private:
+				uint64_t state_;
+		};
+
+		//! The field of the n-th lowest field of b, which must have more than n fields
+		inline uint32_t nthField(Bitboard b, uint32_t n) noexcept
+		{
+#ifdef __BMI2__
+			return static_cast<uint32_t>(__builtin_ctzll(_pdep_u64(Bitboard{1} << n, b)));
+#else
+			for(; n != 0; --n) {
+				b &= b - 1;
+			}
+			return static_cast<uint32_t>(__builtin_ctzll(b));
+#endif
+		}
+
+		//! Pick a random move of the moving player without generating all of them, for playouts
+		/*!
+		 * The move is lightly biased: spawns are preferred over jumps since they gain a blob,
+		 * and of two random fields the one capturing more opponent blobs is taken.
+		 * \return Whether there is a move at all, m being unchanged otherwise
+		 */
+		template<uint32_t Size>
+			bool randomMove(BasicStatus<Size> const & status, PlayoutRandom & random, Move & m) noexcept
+			{
+				const auto own = status.movingBlobs();
+				const auto empty = status.empty();
+				const auto near = dilate<Size>(own) & empty;
+				const auto targets = near != 0 ? near : dilate<Size>(dilate<Size>(own)) & empty;
+				if(targets == 0) {
+					return false;
+				}
+				const auto count = popcount(targets);
+				auto to = nthField(targets, random.below(count));
+				if(count > 1) {
+					const auto other = nthField(targets, random.below(count));
+					if(popcount(neighbourMasks<Size>[other] & status.waitingBlobs()) > popcount(neighbourMasks<Size>[to] & status.waitingBlobs())) {
+						to = other;
+					}
+				}
+				if(near != 0) {
+					m = Move::spawn(to);
+				} else {
+					const auto sources = jumpMasks<Size>[to] & own;
+					m = Move::jump(nthField(sources, random.below(popcount(sources))), to);
+				}
+				return true;
+			}
+	}
+
+	//! Monte Carlo tree search with PUCT selection and random playouts, as an alternative to BasicSearcher
+	/*!
+	 * The tree lives in a pool of nodes allocated once, whose children are handed out in blocks.
+	 * All threads walk the same tree. A thread counts its visit on every node of its path before the playout,
+	 * which lowers the value of that path for the other threads until the result is in (virtual loss).
+	 * A node gets its children on its second visit, with priors favouring moves that gain more blobs.
+	 * When the next search starts from a status at most two moves below the previous root, that subtree is kept.
+	 * The search stops at the time, node (playout) or stop limits of SearchLimits, or at twice the soft time limit;
+	 * without time or node limit it runs defaultPlayouts.
+	 */
+	template<uint32_t Size>
+		class BasicMctsSearcher
+		{
+			public:
+				//! The number of playouts without time or node limit
+				static constexpr uint64_t defaultPlayouts = 100000;
+
+				/*!
+				 * \param[in] threads The total number of threads, including the calling one
+				 * \param[in] megabytes The size of the node pool
+				 */
+				BasicMctsSearcher(const uint32_t threads, const std::size_t megabytes) :
+					threads_(std::max(threads, 1U)),
+					capacity_(static_cast<uint32_t>(std::min<std::size_t>(std::max<std::size_t>(megabytes * 1024 * 1024 / sizeof(Node), 2), UINT32_MAX))),
+					nodes_(new Node[capacity_])
+				{
+				}
+
+				//! The total number of threads, including the calling one
+				uint32_t threads() const noexcept
+				{
+					return threads_;
+				}
+
+				//! Forget the tree, so that the next search starts from scratch
+				void clear() noexcept
+				{
+					used_ = 0;
+				}
+
+				//! Search a Status
+				/*!
+				 * The best move is the most visited one. The score is the winning chance of the moving player,
+				 * mapped linearly onto plus or minus Size blobs. The principal variation follows the most visited moves,
+				 * and its length is the depth of the result. The nodes of the result are the playouts.
+				 */
+				SearchResult search(BasicStatus<Size> const & status, SearchLimits const & limits)
+				{
+					reuseOrReset(status);
+					const auto start = std::chrono::steady_clock::now();
+					auto deadline = limits.time > std::chrono::steady_clock::duration::zero() ? start + limits.time : std::chrono::steady_clock::time_point::max();
+					if(limits.softTime > std::chrono::steady_clock::duration::zero()) {
+						// There are no iterations to finish, so the search takes the time an iterative search would take on average.
+						deadline = std::min(deadline, start + 2 * limits.softTime);
+					}
+					const auto budget = limits.nodes != 0 ? limits.nodes : deadline != std::chrono::steady_clock::time_point::max() ? UINT64_MAX : defaultPlayouts;
+					playouts_.store(0, std::memory_order_relaxed);
+					std::atomic<bool> done{false};
+					const auto run = [&] (const uint32_t thread) {
+						detail::PlayoutRandom random(((searches_ + 1) * 0x9e3779b97f4a7c15ULL) ^ (thread + 1) * 0xbf58476d1ce4e5b9ULL);
+						uint64_t nextProgress = 1024;
+						while(!done.load(std::memory_order_relaxed)) {
+							const auto playouts = playouts_.fetch_add(1, std::memory_order_relaxed) + 1;
+							playout(random);
+							if(playouts >= budget || (limits.stop != nullptr && limits.stop->load(std::memory_order_relaxed))
+									|| (playouts % 256 == 0 && std::chrono::steady_clock::now() >= deadline)) {
+								done.store(true, std::memory_order_relaxed);
+							}
+							if(thread == 0 && playouts >= nextProgress && limits.progress) {
+								limits.progress(result(std::chrono::steady_clock::now() - start));
+								nextProgress = 2 * playouts;
+							}
+						}
+					};
+					std::vector<std::thread> helpers;
+					for(uint32_t i = 1; i != threads_; ++i) {
+						helpers.emplace_back(run, i);
+					}
+					run(0);
+					for(auto & helper : helpers) {
+						helper.join();
+					}
+					++searches_;
+					return result(std::chrono::steady_clock::now() - start);
+				}
+
+			private:
+				//! A node of the tree, which is reached by move from its parent
+				struct Node
+				{
+					Move move;
+
+					//! The number of children, which are stored from first on once state is expanded
+					uint16_t children;
+					uint32_t first;
+
+					//! The share of the visits PUCT aims to give this node
+					float prior;
+
+					std::atomic<uint8_t> state;
+
+					//! How often the node was visited, including visits whose result is not in yet
+					std::atomic<uint32_t> visits;
+
+					//! Twice the games won by the player that made move, plus the draws
+					std::atomic<uint32_t> value;
+
+					void reset(const Move m, const float p) noexcept
+					{
+						move = m;
+						children = 0;
+						first = 0;
+						prior = p;
+						state.store(leaf, std::memory_order_relaxed);
+						visits.store(0, std::memory_order_relaxed);
+						value.store(0, std::memory_order_relaxed);
+					}
+				};
+
+				//! The states of a Node
+				static constexpr uint8_t leaf = 0;
+				static constexpr uint8_t expanding = 1;
+				static constexpr uint8_t expanded = 2;
+
+				//! How strongly PUCT explores moves with few visits
+				static constexpr float exploration = 1.5f;
+
+				//! The value a Node without visits is assumed to have, as a winning chance
+				static constexpr float firstPlayValue = 0.5f;
+
+				//! Playouts end after that many moves per field, and are scored by the material then
+				static constexpr uint32_t playoutMovesPerField = 2;
+
+				//! Keep the subtree of the new root, or start a new tree
+				void reuseOrReset(BasicStatus<Size> const & status)
+				{
+					if(used_ != 0 && used_ < capacity_ / 2) {
+						if(rootStatus_ == status) {
+							return;
+						}
+						// Look at the children and grandchildren of the old root.
+						Node const & root = nodes_[root_];
+						if(root.state.load(std::memory_order_acquire) == expanded) {
+							for(uint32_t i = root.first; i != root.first + root.children; ++i) {
+								auto child = rootStatus_;
+								child.play(nodes_[i].move);
+								if(child == status) {
+									setRoot(i, status);
+									return;
+								}
+								if(nodes_[i].state.load(std::memory_order_acquire) != expanded) {
+									continue;
+								}
+								for(uint32_t j = nodes_[i].first; j != nodes_[i].first + nodes_[i].children; ++j) {
+									auto grandchild = child;
+									grandchild.play(nodes_[j].move);
+									if(grandchild == status) {
+										setRoot(j, status);
+										return;
+									}
+								}
+							}
+						}
+					}
+					used_ = 1;
+					nodes_[0].reset(Move::pass(), 1);
+					setRoot(0, status);
+				}
+
+				void setRoot(const uint32_t root, BasicStatus<Size> const & status) noexcept
+				{
+					root_ = root;
+					rootStatus_ = status;
+				}
+
+				//! Walk down the tree from the root, expand, play out and update every node on the path
+				void playout(detail::PlayoutRandom & random) noexcept
+				{
+					std::array<uint32_t, maxDepth * 4> path;
+					uint32_t length = 0;
+					auto status = rootStatus_;
+					uint32_t index = root_;
+					nodes_[index].visits.fetch_add(1, std::memory_order_relaxed);
+					path[length++] = index;
+					while(!status.gameOver() && length != path.size()) {
+						Node & node = nodes_[index];
+						auto state = node.state.load(std::memory_order_acquire);
+						if(state == leaf && node.visits.load(std::memory_order_relaxed) > 1) {
+							auto expected = leaf;
+							if(node.state.compare_exchange_strong(expected, expanding, std::memory_order_acq_rel)) {
+								state = expand(node, status) ? expanded : leaf;
+								node.state.store(state, std::memory_order_release);
+							}
+						}
+						if(state != expanded) {
+							break;
+						}
+						index = select(node);
+						nodes_[index].visits.fetch_add(1, std::memory_order_relaxed);
+						path[length++] = index;
+						status.play(nodes_[index].move);
+					}
+
+					const auto whiteResult = simulate(status, random);
+					// The player that made the move into the node at the end of the path is the one that is not moving there.
+					bool whiteMoved = !status.whiteMoves();
+					for(uint32_t i = length; i-- != 0; ) {
+						nodes_[path[i]].value.fetch_add(whiteMoved ? whiteResult : 2 - whiteResult, std::memory_order_relaxed);
+						whiteMoved = !whiteMoved;
+					}
+				}
+
+				//! Give a Node its children
+				/*!
+				 * \return Whether the pool had room for them
+				 */
+				bool expand(Node & node, BasicStatus<Size> const & status) noexcept
+				{
+					std::array<Move, upperLimitMoves<Size>> moves;
+					std::array<uint8_t, upperLimitMoves<Size>> captures;
+					auto len = generateMoves(status, moves.begin());
+					if(len == 0) {
+						moves[0] = Move::pass();
+						captures[0] = 0;
+						len = 1;
+					} else {
+						detail::captureCounts<Size>(status.waitingBlobs(), moves.data(), len, captures.data());
+					}
+					const auto first = used_.fetch_add(len, std::memory_order_relaxed);
+					if(first + len > capacity_ || first + len < first) {
+						used_.store(capacity_, std::memory_order_relaxed);
+						return false;
+					}
+					float sum = 0;
+					for(uint32_t i = 0; i != len; ++i) {
+						sum += prior(moves[i], captures[i]);
+					}
+					for(uint32_t i = 0; i != len; ++i) {
+						nodes_[first + i].reset(moves[i], prior(moves[i], captures[i]) / sum);
+					}
+					node.first = first;
+					node.children = static_cast<uint16_t>(len);
+					return true;
+				}
+
+				//! The unnormalised prior of a move, rising with the blobs it gains
+				static float prior(const Move m, const uint32_t captured) noexcept
+				{
+					const auto gained = static_cast<float>(2 * captured + (m.isJump() ? 0 : 1) + 1);
+					return gained * gained;
+				}
+
+				//! The child of an expanded Node with the highest PUCT value
+				uint32_t select(Node const & node) const noexcept
+				{
+					const auto parentVisits = std::sqrt(static_cast<float>(node.visits.load(std::memory_order_relaxed)));
+					uint32_t best = node.first;
+					float bestValue = -1;
+					for(uint32_t i = node.first; i != node.first + node.children; ++i) {
+						Node const & child = nodes_[i];
+						const auto visits = child.visits.load(std::memory_order_relaxed);
+						const auto q = visits == 0 ? firstPlayValue : static_cast<float>(child.value.load(std::memory_order_relaxed)) / static_cast<float>(2 * visits);
+						const auto value = q + exploration * child.prior * parentVisits / static_cast<float>(1 + visits);
+						if(value > bestValue) {
+							bestValue = value;
+							best = i;
+						}
+					}
+					return best;
+				}
+
+				//! Play random moves until the game is over, returning 2 if white wins, 1 for a draw and 0 if black wins
+				static uint32_t simulate(BasicStatus<Size> status, detail::PlayoutRandom & random) noexcept
+				{
+					for(uint32_t ply = 0; ply != playoutMovesPerField * Size * Size && !status.gameOver(); ++ply) {
+						Move m;
+						if(detail::randomMove(status, random, m)) {
+							status.makeMove(m);
+						} else {
+							status.switchPlayerTurn();
+						}
+					}
+					const auto score = status.score();
+					return score > 0 ? 2 : score < 0 ? 0 : 1;
+				}
+
+				//! The most visited child of an expanded Node, or nullptr
+				Node const * mostVisited(Node const & node) const noexcept
+				{
+					if(node.state.load(std::memory_order_acquire) != expanded) {
+						return nullptr;
+					}
+					Node const * best = nullptr;
+					for(uint32_t i = node.first; i != node.first + node.children; ++i) {
+						if(best == nullptr || nodes_[i].visits.load(std::memory_order_relaxed) > best->visits.load(std::memory_order_relaxed)) {
+							best = &nodes_[i];
+						}
+					}
+					return best;
+				}
+
+				//! The result of the search so far
+				SearchResult result(const std::chrono::steady_clock::duration elapsed) const
+				{
+					SearchResult r;
+					r.nodes = playouts_.load(std::memory_order_relaxed);
+					r.stats.evaluations = r.nodes;
+					for(Node const * node = mostVisited(nodes_[root_]); node != nullptr && node->visits.load(std::memory_order_relaxed) != 0; node = mostVisited(*node)) {
+						r.pv.push_back(node->move);
+					}
+					r.depth = static_cast<uint32_t>(r.pv.size());
+					if(r.pv.empty()) {
+						// The game is over, or not even the root was expanded.
+						std::array<Move, upperLimitMoves<Size>> moves;
+						if(generateMoves(rootStatus_, moves.begin()) != 0) {
+							r.pv.push_back(moves[0]);
+						}
+						r.move = r.pv.empty() ? Move::pass() : r.pv.front();
+						r.score = rootStatus_.gameOver() ? rootStatus_.score() * blobScore : 0;
+					} else {
+						r.move = r.pv.front();
+						Node const & best = *mostVisited(nodes_[root_]);
+						const auto chance = static_cast<double>(best.value.load(std::memory_order_relaxed)) / static_cast<double>(2 * best.visits.load(std::memory_order_relaxed));
+						const auto score = static_cast<Score>(std::lround((2 * chance - 1) * Size * blobScore));
+						r.score = rootStatus_.whiteMoves() ? score : - score;
+					}
+					r.stats.iterations.push_back({r.depth, r.nodes, elapsed});
+					return r;
+				}
+
+				uint32_t threads_;
+
+				//! The size of the pool
+				uint32_t capacity_;
+
+				//! The pool of all nodes, of which the first used_ ones are in use
+				std::unique_ptr<Node[]> nodes_;
+				std::atomic<uint32_t> used_{0};
+
+				//! The root of the tree and its Status
+				uint32_t root_ = 0;
+				BasicStatus<Size> rootStatus_;
+
+				//! The playouts of the running search
+				std::atomic<uint64_t> playouts_{0};
+
+				//! The number of searches so far, from which the random numbers are seeded
+				uint64_t searches_ = 0;
+		};
+
+	//! The MctsSearcher of the standard board
+	using MctsSearcher = BasicMctsSearcher<boardSize>;
+}
+
+#endif
@@ -0,0 +1,272 @@
+/*!
+ * \file atasol_nnue.hpp
+ * \brief atasol neural network evaluation
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_NNUE_HPP_
+#define ATASOL_NNUE_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mapping.hpp"
+#include "solver.hpp"
+
+namespace atasol {
+	//! A small quantised neural network that evaluates statuses of a board of Size x Size fields
+	/*!
+	 * The inputs are one per field for a white blob, one per field for a black blob, one per blocked field and one for black to move.
+	 * They feed a hidden layer of int16 sums, the Accumulator, which a search keeps up to date move by move
+	 * by adding and subtracting the weights of the few inputs that change, see update().
+	 * The hidden values are clipped to [0, 127] and combined by int8 weights into the estimate of evaluate().
+	 *
+	 * The file is a header followed by, in the byte order of the machine that wrote it:
+	 * the int16 weights of every input to all hidden values, the int16 hidden biases, the int8 output weights,
+	 * the int32 output bias and a uint32 shift, by which the output is divided by a power of two to get units of blobScore.
+	 * With AVX2, 16 hidden values are processed at once. Define ATASOL_NO_AVX2 to always use the scalar version.
+	 */
+	template<uint32_t Size>
+		class Network
+		{
+			public:
+				static constexpr uint32_t fields = Size * Size;
+
+				//! The number of inputs, whose index is that of the field for white blobs, plus fields for black blobs and 2 * fields for blocked fields
+				static constexpr uint32_t inputs = 3 * fields + 1;
+
+				//! The input that is one if black moves
+				static constexpr uint32_t blackMovesInput = 3 * fields;
+
+				//! The number of hidden values
+				static constexpr uint32_t hidden = 64;
+
+				//! The hidden values before clipping for one Status
+				using Accumulator = std::array<int16_t, hidden>;
+
+				//! Load a file written for this board size, replacing any network loaded before
+				/*!
+				 * \return Whether path is a network of this board size
+				 */
+				bool open(std::string const & path)
+				{
+					open_ = false;
+					MappedFile file;
+					if(!file.open(path) || file.size() != fileSize || std::memcmp(file.data(), header().data(), header().size()) != 0) {
+						return false;
+					}
+					auto p = file.data() + headerSize;
+					const auto read = [&p] (void * target, const std::size_t bytes) {
+						std::memcpy(target, p, bytes);
+						p += bytes;
+					};
+					inputWeights_.resize(inputs * hidden);
+					read(inputWeights_.data(), inputWeights_.size() * sizeof(int16_t));
+					read(hiddenBiases_.data(), sizeof(hiddenBiases_));
+					read(outputWeights_.data(), sizeof(outputWeights_));
+					read(&outputBias_, sizeof(outputBias_));
+					read(&outputShift_, sizeof(outputShift_));
+					open_ = outputShift_ < 31;
+					return open_;
+				}
+
+				//! Whether a network is loaded
+				bool isOpen() const noexcept
+				{
+					return open_;
+				}
+
+				//! Compute the Accumulator of a Status from scratch
+				void refresh(BasicStatus<Size> const & status, Accumulator & accumulator) const noexcept
+				{
+					accumulator = hiddenBiases_;
+					for(uint32_t pos = 0; pos != fields; ++pos) {
+						const auto entry = status[pos];
+						if(entry != Entry::Empty) {
+							addRow(accumulator, (static_cast<uint32_t>(entry) - 1) * fields + pos);
+						}
+					}
+					if(status.blackMoves()) {
+						addRow(accumulator, blackMovesInput);
+					}
+				}
+
+				//! Compute the Accumulator after a move from the one before
+				/*!
+				 * \param[in] before The Accumulator of the Status the move was made in
+				 * \param[out] after Receives the Accumulator of the Status after the move
+				 * \param[in] whiteMoved Whether white made the move
+				 * \param[in] m The move, which may be a pass
+				 * \param[in] captured The blobs that changed color, as returned by BasicStatus::makeMove()
+				 */
+				void update(Accumulator const & before, Accumulator & after, const bool whiteMoved, const Move m, Bitboard captured) const noexcept
+				{
+					// A move adds at most the blob moved to, eight captured blobs and a side to move, and removes as many.
+					std::array<uint32_t, 10> added;
+					std::array<uint32_t, 10> removed;
+					uint32_t addedCount = 0;
+					uint32_t removedCount = 0;
+					const uint32_t own = whiteMoved ? 0 : fields;
+					const uint32_t opponent = whiteMoved ? fields : 0;
+					// The player to move changes with every move, including a pass.
+					if(whiteMoved) {
+						added[addedCount++] = blackMovesInput;
+					} else {
+						removed[removedCount++] = blackMovesInput;
+					}
+					if(!m.isPass()) {
+						added[addedCount++] = own + m.to;
+						if(m.isJump()) {
+							removed[removedCount++] = own + m.from;
+						}
+						while(captured != 0) {
+							const auto pos = detail::popLowest(captured);
+							added[addedCount++] = own + pos;
+							removed[removedCount++] = opponent + pos;
+						}
+					}
+					uint32_t i = 0;
+#ifdef ATASOL_AVX2
+					for(; i != hidden; i += 16) {
+						__m256i sum = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(before.data() + i));
+						for(uint32_t j = 0; j != addedCount; ++j) {
+							sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(row(added[j]) + i)));
+						}
+						for(uint32_t j = 0; j != removedCount; ++j) {
+							sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(row(removed[j]) + i)));
+						}
+						_mm256_storeu_si256(reinterpret_cast<__m256i *>(after.data() + i), sum);
+					}
+#endif
+					for(; i != hidden; ++i) {
+						auto sum = before[i];
+						for(uint32_t j = 0; j != addedCount; ++j) {
+							sum = static_cast<int16_t>(sum + row(added[j])[i]);
+						}
+						for(uint32_t j = 0; j != removedCount; ++j) {
+							sum = static_cast<int16_t>(sum - row(removed[j])[i]);
+						}
+						after[i] = sum;
+					}
+				}
+
+				//! Estimate the score of the Status of an Accumulator from the point of view of white, see BasicStatus::evaluation()
+				Score evaluate(Accumulator const & accumulator) const noexcept
+				{
+					int32_t sum = outputBias_;
+					uint32_t i = 0;
+#ifdef ATASOL_AVX2
+					const __m256i limit = _mm256_set1_epi16(127);
+					__m256i sums = _mm256_setzero_si256();
+					for(; i != hidden; i += 32) {
+						const __m256i low = _mm256_min_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(accumulator.data() + i)), limit);
+						const __m256i high = _mm256_min_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(accumulator.data() + i + 16)), limit);
+						// Packing clips negative values to zero, but interleaves the 128 bit lanes of low and high.
+						const __m256i clipped = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8);
+						const __m256i products = _mm256_maddubs_epi16(clipped, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(outputWeights_.data() + i)));
+						sums = _mm256_add_epi32(sums, _mm256_madd_epi16(products, _mm256_set1_epi16(1)));
+					}
+					const __m128i halves = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+					const __m128i pairs = _mm_add_epi32(halves, _mm_shuffle_epi32(halves, 0x4e));
+					sum += _mm_cvtsi128_si32(_mm_add_epi32(pairs, _mm_shuffle_epi32(pairs, 0xb1)));
+#endif
+					for(; i != hidden; ++i) {
+						sum += std::max<int32_t>(0, std::min<int32_t>(accumulator[i], 127)) * outputWeights_[i];
+					}
+					return detail::clampEstimate<Size>(sum / (int32_t{1} << outputShift_));
+				}
+
+				//! Write a network that estimates the material difference like BasicStatus::score() does before the game is over
+				/*!
+				 * It counts the blobs of white and black in one hidden value each. Useful as a start for training and to check the evaluator.
+				 * \return Whether the file was written
+				 */
+				static bool writeMaterial(std::string const & path)
+				{
+					std::vector<int16_t> weights(inputs * hidden, 0);
+					for(uint32_t pos = 0; pos != fields; ++pos) {
+						weights[pos * hidden + 0] = 1;
+						weights[(fields + pos) * hidden + 1] = 1;
+					}
+					Accumulator biases{};
+					std::array<int8_t, hidden> outputWeights{};
+					outputWeights[0] = static_cast<int8_t>(blobScore);
+					outputWeights[1] = static_cast<int8_t>(- blobScore);
+					const int32_t outputBias = 0;
+					const uint32_t outputShift = 0;
+
+					std::ofstream file(path, std::ios::binary | std::ios::trunc);
+					file.write(header().data(), static_cast<std::streamsize>(header().size()));
+					file.write(reinterpret_cast<char const *>(weights.data()), static_cast<std::streamsize>(weights.size() * sizeof(int16_t)));
+					file.write(reinterpret_cast<char const *>(biases.data()), static_cast<std::streamsize>(sizeof(biases)));
+					file.write(reinterpret_cast<char const *>(outputWeights.data()), static_cast<std::streamsize>(sizeof(outputWeights)));
+					file.write(reinterpret_cast<char const *>(&outputBias), static_cast<std::streamsize>(sizeof(outputBias)));
+					file.write(reinterpret_cast<char const *>(&outputShift), static_cast<std::streamsize>(sizeof(outputShift)));
+					return static_cast<bool>(file);
+				}
+
+			private:
+				//! The size of the header, which is "atasolnn" followed by the board size as a digit and padding
+				static constexpr std::size_t headerSize = 16;
+
+				static constexpr std::size_t fileSize = headerSize + inputs * hidden * sizeof(int16_t) + hidden * sizeof(int16_t)
+					+ hidden * sizeof(int8_t) + sizeof(int32_t) + sizeof(uint32_t);
+
+				static std::array<char, headerSize> header() noexcept
+				{
+					std::array<char, headerSize> r{{'a', 't', 'a', 's', 'o', 'l', 'n', 'n', static_cast<char>('0' + Size)}};
+					return r;
+				}
+
+				//! The weights of one input to all hidden values
+				int16_t const * row(const uint32_t input) const noexcept
+				{
+					return inputWeights_.data() + input * hidden;
+				}
+
+				void addRow(Accumulator & accumulator, const uint32_t input) const noexcept
+				{
+					const auto weights = row(input);
+					for(uint32_t i = 0; i != hidden; ++i) {
+						accumulator[i] = static_cast<int16_t>(accumulator[i] + weights[i]);
+					}
+				}
+
+				bool open_ = false;
+				std::vector<int16_t> inputWeights_;
+				Accumulator hiddenBiases_{};
+				std::array<int8_t, hidden> outputWeights_{};
+				int32_t outputBias_ = 0;
+				uint32_t outputShift_ = 0;
+		};
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*!
+ * \file atasol_perft.hpp
+ * \brief atasol move generation node counting
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_PERFT_HPP_
+#define ATASOL_PERFT_HPP_
+
+#include <cstdint>
+
+#include <array>
+
+#include "solver.hpp"
+
+namespace atasol {
+	//! Count the leaves of the game tree below a Status, to check and benchmark move generation
+	/*!
+	 * A player that cannot move passes, which counts as one move, unless the game is over.
+	 * At the last level the moves are only counted instead of made.
+	 * \param[in] status The Status below which to count, moves are made on it and taken back
+	 * \param[in] depth The number of moves to descend
+	 * \return The number of move sequences of length depth
+	 */
+	template<uint32_t Size>
+		uint64_t perft(BasicStatus<Size> & status, const uint32_t depth) noexcept
+		{
+			if(depth == 0) {
+				return 1;
+			}
+			std::array<Move, upperLimitMoves<Size>> moves;
+			const auto len = generateMoves(status, moves.begin());
+			if(len == 0) {
+				if(status.gameOver()) {
+					return 0;
+				}
+				status.switchPlayerTurn();
+				const auto r = perft(status, depth - 1);
+				status.switchPlayerTurn();
+				return r;
+			}
+			if(depth == 1) {
+				return len;
+			}
+			uint64_t r = 0;
+			for(uint32_t i = 0; i != len; ++i) {
+				const auto captured = status.makeMove(moves[i]);
+				r += perft(status, depth - 1);
+				status.unmakeMove(moves[i], captured);
+			}
+			return r;
+		}
+
+	//! Count the statuses below a Status whose evaluation() changes under a board symmetry
+	/*!
+	 * Symmetric statuses are one entry of the OpeningBook, so they have to evaluate the same.
+	 * \param[in] status The Status below which to check, moves are made on it and taken back
+	 * \param[in] depth The number of moves to descend
+	 * \return The number of statuses, including status itself, with at least one symmetric status evaluating differently
+	 */
+	template<uint32_t Size>
+		uint64_t asymmetricEvaluations(BasicStatus<Size> & status, const uint32_t depth) noexcept
+		{
+			uint64_t r = 0;
+			const auto evaluation = status.evaluation();
+			for(uint32_t s = 1; s != detail::symmetries; ++s) {
+				if(status.transformed(s).evaluation() != evaluation) {
+					r = 1;
+					break;
+				}
+			}
+			if(depth == 0) {
+				return r;
+			}
+			std::array<Move, upperLimitMoves<Size>> moves;
+			const auto len = generateMoves(status, moves.begin());
+			for(uint32_t i = 0; i != len; ++i) {
+				const auto captured = status.makeMove(moves[i]);
+				r += asymmetricEvaluations(status, depth - 1);
+				status.unmakeMove(moves[i], captured);
+			}
+			return r;
+		}
+
+	//! A position with known perft() results
+	struct PerftReference
+	{
+		char const * fen;
+
+		//! The number of known results
+		uint32_t depth;
+
+		//! The expected results for depths 1, 2, ..., depth
+		std::array<uint64_t, 6> nodes;
+	};
+
+	//! Positions whose perft() results were verified with an independent move generator
+	constexpr std::array<PerftReference, 14> perftReferences{{
+		// The starting status, with either player to move
+		{"x5o/7/7/7/7/7/o5x x 0 1", 5, {{16, 256, 6460, 155888, 4752668}}},
+		{"x5o/7/7/7/7/7/o5x o 0 1", 5, {{16, 256, 6460, 155888, 4752668}}},
+		// Some middle game
+		{"x5o/7/2x1o2/3x3/2o1x2/7/o5x x 0 1", 4, {{66, 2826, 178162, 7937488}}},
+		{"x1o1x1o/7/o1x1o1x/7/x1o1x1o/7/o1x1o1x x 0 1", 4, {{69, 4064, 274752, 16597960}}},
+		{"o5o/7/2x4/7/7/7/o5o x 0 1", 5, {{23, 694, 15345, 563841, 16231019}}},
+		// White cannot reach any empty field and has to pass
+		{"7/7/7/7/ooooooo/ooooooo/xxxxxxx x 0 1", 5, {{1, 75, 249, 14270, 452980}}},
+		// A single empty field, which jumps free up again
+		{"xxxxxxx/ooooooo/xxxxxxx/ooooooo/xxxxxxx/ooooooo/xxxxxx1 o 0 1", 6, {{2, 4, 9, 22, 72, 278}}},
+		// Black has no blobs left, so the game is over
+		{"x5x/7/7/7/7/7/x5x o 0 1", 2, {{0, 0}}},
+		// Blocked fields, which can be jumped over but not moved to
+		{"x5o/7/2-1-2/7/2-1-2/7/o5x x 0 1", 4, {{14, 196, 4184, 86528}}},
+		{"x5o/7/3-3/2-1-2/3-3/7/o5x o 0 1", 4, {{16, 256, 5948, 133264}}},
+		{"x-4o/7/2x1o2/-2x2-/2o1x2/7/o4-x x 0 1", 3, {{60, 2426, 139390}}},
+		// The starting statuses of smaller boards
+		{"x2o/4/4/o2x x 0 1", 6, {{16, 176, 2408, 26756, 350092, 4363464}}},
+		{"x3o/5/5/5/o3x x 0 1", 5, {{16, 244, 4592, 86956, 1790556}}},
+		{"x4o/6/6/6/6/o4x x 0 1", 4, {{16, 256, 5884, 131140}}},
+	}};
+}
+
+#endif
@@ -0,0 +1,1218 @@
+/*!
+ * \file atasol_search.hpp
+ * \brief atasol iterative deepening search
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_SEARCH_HPP_
+#define ATASOL_SEARCH_HPP_
+
+#include <cassert>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "nnue.hpp"
+#include "solver.hpp"
+#include "tablebase.hpp"
+
+namespace atasol {
+	//! The deepest a search may ever go
+	constexpr uint32_t maxDepth = 64;
+
+	//! A score beyond every evaluation a Status of any size can receive
+	constexpr Score infinity = (static_cast<Score>(sizeof(Bitboard) * 8) + 1) * blobScore;
+
+	struct SearchResult;
+
+	//! When a search has to stop
+	struct SearchLimits
+	{
+		//! The depth of the last iteration
+		uint32_t depth = 5;
+
+		//! Flag that another thread may set to abort the search, or nullptr
+		std::atomic<bool> const * stop = nullptr;
+
+		//! How long the search may take before it is aborted, or zero for no limit
+		std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+
+		//! How long the search may take before no further iteration is started, or zero for no limit
+		/*!
+		 * The Searcher stretches this while the best move changes or the score drops between iterations,
+		 * and shrinks it once the best move has stayed the same for a few iterations. See budgetTime().
+		 * With a single legal move, the search stops after the first iteration.
+		 */
+		std::chrono::steady_clock::duration softTime = std::chrono::steady_clock::duration::zero();
+
+		//! How many statuses the search may visit before it is aborted, or zero for no limit
+		/*!
+		 * The count is only looked at now and then, so a search may visit a few more.
+		 */
+		uint64_t nodes = 0;
+
+		//! Statuses with at most that many empty fields are solved to the end of the game instead of being searched to depth
+		uint32_t endgameEmpty = 5;
+
+		//! How many of the best root moves a BasicSearcher ranks with exact scores in SearchResult::lines, if more than one
+		/*!
+		 * Every root move is searched with a window that starts at the score of the multiPv-th best move so far,
+		 * so moves that cannot enter the ranking are refuted as cheaply as in a normal search.
+		 * The root is searched without aspiration window and without reductions then, see reductions.
+		 */
+		uint32_t multiPv = 1;
+
+		//! Whether late moves may be searched with reduced depth
+		/*!
+		 * Which moves are reduced depends on the move order, and thereby on the windows and on what earlier searches left behind,
+		 * so only a search without reductions scores every move with its exact value at the given depth.
+		 * Searches with multiPv above one never reduce.
+		 */
+		bool reductions = true;
+
+		//! Whether the search starts a new generation of the TranspositionTable, which ages the entries of earlier searches
+		/*!
+		 * Searches that run side by side on one table, other than the helpers of a ParallelSearcher, clear this
+		 * and start the generation themselves, so that they do not age each other's entries.
+		 */
+		bool ageTable = true;
+
+		//! Called with the result so far after every completed iteration, if set
+		std::function<void(SearchResult const &)> progress;
+	};
+
+	//! The time a move on the clock reserves for the communication and bookkeeping around the search
+	constexpr std::chrono::milliseconds moveOverhead{10};
+
+	//! Set the time limits of a move from the clock of the moving player
+	/*!
+	 * The move is budgeted an even share of the remaining time and most of the increment. The soft limit is half of that,
+	 * since an iteration started before it mostly completes within the budget, and the hard limit three times that,
+	 * but never more than half the remaining time, or all of it for the last move before the clock is topped up.
+	 * \param[out] limits Receives the hard limit in time and the soft limit in softTime
+	 * \param[in] remaining The time left on the clock
+	 * \param[in] increment The time added to the clock after every move
+	 * \param[in] movesToGo The moves until the clock is next topped up, or zero if it never is,
+	 * in which case the moves left are guessed from the empty fields, each of which most moves fill
+	 * \param[in] emptyFields The empty fields of the status to move in
+	 */
+	inline void budgetTime(SearchLimits & limits, const std::chrono::steady_clock::duration remaining, const std::chrono::steady_clock::duration increment,
+			const uint32_t movesToGo, const uint32_t emptyFields) noexcept
+	{
+		using Duration = std::chrono::steady_clock::duration;
+		const auto moves = movesToGo != 0 ? movesToGo : std::min(std::max(emptyFields / 2 + 8, 10U), 40U);
+		const auto available = std::max(remaining - std::chrono::duration_cast<Duration>(moveOverhead), Duration{1});
+		const auto budget = std::min(available / moves + increment * 3 / 4, available);
+		// A hard limit of zero would be none at all.
+		limits.time = std::max(std::min(3 * budget, moves == 1 ? available : available / 2), Duration{1});
+		limits.softTime = std::min(budget / 2, limits.time);
+	}
+
+	//! What a search did, which every Searcher counts on its own
+	struct SearchStats
+	{
+		//! One completed iteration of the iterative deepening
+		struct Iteration
+		{
+			uint32_t depth;
+
+			//! The statuses visited during this iteration alone
+			uint64_t nodes;
+
+			//! The time this iteration alone took
+			std::chrono::steady_clock::duration time;
+		};
+
+		//! The statuses whose score was estimated or computed without searching their moves
+		uint64_t evaluations = 0;
+
+		//! The statuses where a move reached beta, so that the remaining moves were skipped
+		uint64_t cutoffs = 0;
+
+		//! The cutoffs by the first move searched
+		uint64_t firstMoveCutoffs = 0;
+
+		//! How often the TranspositionTable was looked up, and how often it knew the status
+		uint64_t tableProbes = 0;
+		uint64_t tableHits = 0;
+
+		//! The iterations of the main Searcher
+		std::vector<Iteration> iterations;
+
+		//! The fraction of cutoffs by the first move, which is high if moves are ordered well
+		double firstMoveCutoffRate() const noexcept
+		{
+			return cutoffs == 0 ? 0 : static_cast<double>(firstMoveCutoffs) / static_cast<double>(cutoffs);
+		}
+
+		//! The fraction of TranspositionTable lookups that knew the status
+		double tableHitRate() const noexcept
+		{
+			return tableProbes == 0 ? 0 : static_cast<double>(tableHits) / static_cast<double>(tableProbes);
+		}
+
+		//! The effective branching factor, which is how many times the nodes of the last iteration exceed those of the one before
+		double branchingFactor() const noexcept
+		{
+			if(iterations.size() < 2 || iterations[iterations.size() - 2].nodes == 0) {
+				return 0;
+			}
+			return static_cast<double>(iterations.back().nodes) / static_cast<double>(iterations[iterations.size() - 2].nodes);
+		}
+
+		//! Add the counters of another Searcher, but not its iterations
+		SearchStats & operator+=(SearchStats const & other) noexcept
+		{
+			evaluations += other.evaluations;
+			cutoffs += other.cutoffs;
+			firstMoveCutoffs += other.firstMoveCutoffs;
+			tableProbes += other.tableProbes;
+			tableHits += other.tableHits;
+			return *this;
+		}
+	};
+
+	//! One of the best root moves of a search, see SearchLimits::multiPv
+	struct SearchLine
+	{
+		Move move;
+
+		//! The exact score, positive values being good for white as in SearchResult::score
+		Score score;
+
+		//! The expected continuation, starting with move
+		std::vector<Move> pv;
+	};
+
+	//! The outcome of a search
+	struct SearchResult
+	{
+		//! The best move, which is Move::pass() if the moving player has to pass
+		Move move = Move::pass();
+
+		//! The score of the searched Status, positive values being good for white as with Status::evaluation()
+		Score score = 0;
+
+		//! The depth of the last completed iteration
+		uint32_t depth = 0;
+
+		//! The expected continuation, starting with move
+		std::vector<Move> pv;
+
+		//! The number of statuses visited
+		uint64_t nodes = 0;
+
+		//! What the search did
+		SearchStats stats;
+
+		//! The best root moves of the last completed iteration, best first, if SearchLimits::multiPv is more than one
+		std::vector<SearchLine> lines;
+	};
+
+	namespace detail {
+		//! The scratch space of one level of the search
+		template<uint32_t Size>
+			struct Ply
+			{
+				std::array<Move, upperLimitMoves<Size>> moves;
+				//! The key every move is ordered by, highest first
+				std::array<int32_t, upperLimitMoves<Size>> keys;
+				std::array<uint8_t, upperLimitMoves<Size>> captures;
+				//! The hidden values of the Network for the Status of this level, if a Network evaluates
+				typename Network<Size>::Accumulator accumulator;
+			};
+
+		//! Move the move with the highest key among those from index i on to index i
+		template<uint32_t Size>
+			void pickMove(Ply<Size> & p, const uint32_t i, const uint32_t len) noexcept
+			{
+				uint32_t best = i;
+				for(uint32_t j = i + 1; j < len; ++j) {
+					if(p.keys[j] > p.keys[best]) {
+						best = j;
+					}
+				}
+				std::swap(p.moves[i], p.moves[best]);
+				std::swap(p.keys[i], p.keys[best]);
+			}
+	}
+
+	//! Iterative deepening alpha-beta search that makes and takes back all moves on a single Status
+	/*!
+	 * Scores inside the search are from the point of view of the moving player (negamax).
+	 * Every iteration tries the principal variation of the previous one first,
+	 * and searches with an aspiration window around the previous score.
+	 * All moves after the first one at a node are searched with a null window (principal variation search),
+	 * late moves with reduced depth, and only searched again when they turn out better than expected.
+	 */
+	template<uint32_t Size>
+		class BasicSearcher
+		{
+			public:
+				/*!
+				 * \param[in] table The TranspositionTable to share results between subtrees, searches and threads, or nullptr to not use one
+				 * \param[in] id Zero for a Searcher on its own, or the number of a helper thread of a ParallelSearcher
+				 * \param[in] tablebase The Tablebase to look up statuses below the root in, or nullptr to not use one
+				 * \param[in] network The Network that evaluates statuses, or nullptr to use BasicStatus::evaluation()
+				 */
+				explicit BasicSearcher(TranspositionTable * table = nullptr, const uint32_t id = 0, Tablebase<Size> const * tablebase = nullptr,
+						Network<Size> const * network = nullptr) :
+					table_(table),
+					tablebase_(tablebase),
+					network_(network),
+					id_(id),
+					plies_(new detail::Ply<Size>[maxDepth])
+				{
+					for(auto & history : history_) {
+						history.fill(0);
+					}
+				}
+
+				//! Search a Status
+				/*!
+				 * Iterations deepen from 1 up to limits.depth.
+				 * If the search is stopped or runs out of time, the result of the last completed iteration is returned,
+				 * unless the aborted iteration already found a better move.
+				 * Even a search stopped right away returns a legal move.
+				 */
+				SearchResult search(BasicStatus<Size> const & status, SearchLimits const & limits)
+				{
+					status_ = status;
+					if(network_ != nullptr) {
+						network_->refresh(status_, plies_[0].accumulator);
+					}
+					limits_ = &limits;
+					deadline_ = limits.time > std::chrono::steady_clock::duration::zero() ?
+						std::chrono::steady_clock::now() + limits.time : std::chrono::steady_clock::time_point::max();
+					nodes_ = 0;
+					stats_ = SearchStats();
+					aborted_ = false;
+					prevPvLength_ = 0;
+					lines_.clear();
+					prevLines_.clear();
+					for(auto & killers : killers_) {
+						killers.fill(Move::pass());
+					}
+					for(auto & history : history_) {
+						// Keep some knowledge from the previous search.
+						for(auto & h : history) {
+							h /= 8;
+						}
+					}
+					if(table_ != nullptr && id_ == 0 && limits.ageTable) {
+						table_->newSearch();
+					}
+
+					SearchResult result;
+					// Have a legal move in case we are stopped before the first iteration finishes.
+					const auto rootMoves = generateMoves(status_, plies_[0].moves.begin());
+					if(rootMoves != 0) {
+						result.move = plies_[0].moves[0];
+						result.pv.assign(1, result.move);
+					}
+
+					const auto start = std::chrono::steady_clock::now();
+					// How much the best move changed in recent iterations, and for how many iterations it stayed the same
+					double moveChanges = 0;
+					uint32_t stableIterations = 0;
+					Score score = 0;
+					// Every second helper searches one level deeper, so that the helpers are not all busy with the same iteration.
+					const auto depthOffset = id_ % 2;
+					const auto lastDepth = std::min(limits.depth + depthOffset, maxDepth - 1);
+					for(uint32_t depth = 1 + depthOffset; depth <= lastDepth; ++depth) {
+						const auto iterationStart = std::chrono::steady_clock::now();
+						const auto iterationNodes = nodes_;
+						Score delta = aspirationDelta;
+						Score alpha = - infinity;
+						Score beta = infinity;
+						if(depth >= aspirationDepth && limits.multiPv <= 1) {
+							alpha = std::max(score - delta, - infinity);
+							beta = std::min(score + delta, infinity);
+						}
+						for(;;) {
+							followPv_ = true;
+							rootMove_ = Move::pass();
+							const auto s = negamax(0, depth, alpha, beta);
+							if(aborted_) {
+								break;
+							}
+							if(s <= alpha) {
+								// Fail low, so widen the window downwards.
+								beta = (alpha + beta) / 2;
+								alpha = std::max(s - delta, - infinity);
+							} else if(s >= beta) {
+								// Fail high, so widen the window upwards.
+								beta = std::min(s + delta, infinity);
+							} else {
+								score = s;
+								break;
+							}
+							delta *= 2;
+						}
+						if(aborted_) {
+							if(!rootMove_.isPass()) {
+								// A move of the aborted iteration turned out better than expected.
+								result.move = rootMove_;
+								result.pv.assign(pv_[0].begin(), pv_[0].begin() + pvLength_[0]);
+							}
+							break;
+						}
+						const auto previousMove = result.move;
+						const auto previousScore = status_.whiteMoves() ? result.score : - result.score;
+						result.score = status_.whiteMoves() ? score : -score;
+						result.depth = depth;
+						result.pv.assign(pv_[0].begin(), pv_[0].begin() + pvLength_[0]);
+						result.move = result.pv.empty() ? Move::pass() : result.pv.front();
+						std::copy(pv_[0].begin(), pv_[0].begin() + pvLength_[0], prevPv_.begin());
+						prevPvLength_ = pvLength_[0];
+						if(limits.multiPv > 1) {
+							result.lines = lines_;
+							prevLines_.clear();
+							for(auto & line : result.lines) {
+								line.score = status_.whiteMoves() ? line.score : - line.score;
+								prevLines_.push_back(line.move);
+							}
+						}
+						stats_.iterations.push_back({depth, nodes_ - iterationNodes, std::chrono::steady_clock::now() - iterationStart});
+						if(limits.progress) {
+							result.nodes = nodes_;
+							result.stats = stats_;
+							limits.progress(result);
+						}
+						if(limits.softTime > std::chrono::steady_clock::duration::zero() && rootMoves <= 1) {
+							// A forced move needs no more than the first iteration.
+							break;
+						}
+						// The first iteration has no previous move or score to compare with, so it neither stops the search nor adjusts the time scale.
+						if(limits.softTime > std::chrono::steady_clock::duration::zero() && depth > 1 + depthOffset) {
+							moveChanges = moveChanges / 2 + (result.move != previousMove ? 1 : 0);
+							stableIterations = result.move != previousMove ? 0 : stableIterations + 1;
+							double scale = 1 + moveChanges;
+							if(score < previousScore - blobScore / 2) {
+								// Look for a way out while the score drops.
+								scale *= 1.5;
+							}
+							if(stableIterations >= settledIterations) {
+								scale /= 2;
+							}
+							scale = std::min(scale, maxTimeScale);
+							// Odd and even iterations differ a lot in cost, so the next iteration is predicted from the two before it of the same parity.
+							auto const & iterations = stats_.iterations;
+							const auto n = iterations.size();
+							const auto predicted = n < 4 || iterations[n - 4].time == std::chrono::steady_clock::duration::zero() ? iterations.back().time * maxGrowth
+								: iterations[n - 2].time * std::min(std::max(std::chrono::duration<double>(iterations[n - 2].time) / iterations[n - 4].time, minGrowth), maxGrowth);
+							const auto elapsed = std::chrono::steady_clock::now() - start;
+							if(elapsed >= limits.softTime * scale || elapsed + predicted >= 2 * limits.softTime * scale) {
+								break;
+							}
+						}
+					}
+					result.nodes = nodes_;
+					result.stats = std::move(stats_);
+					return result;
+				}
+
+			private:
+				//! Iterations from this depth on use aspiration windows
+				static constexpr uint32_t aspirationDepth = 3;
+
+				//! The initial distance of the aspiration window bounds from the previous score
+				static constexpr Score aspirationDelta = blobScore;
+
+				//! After the best move stayed the same for that many iterations, the soft time limit is halved
+				static constexpr uint32_t settledIterations = 4;
+
+				//! How far the soft time limit may be stretched
+				static constexpr double maxTimeScale = 3;
+
+				//! The bounds of how many times longer than the iteration two before it an iteration is predicted to take
+				static constexpr double minGrowth = 2;
+				static constexpr double maxGrowth = 20;
+
+				//! The stop flag is only looked at every that many nodes
+				static constexpr uint64_t stopCheckInterval = 1024;
+
+				//! The part of a move's key for being a killer move, which history keys stay below
+				static constexpr int32_t killerKey = 1 << 16;
+
+				//! The part of a move's key for every blob gained relative to the opponent
+				static constexpr int32_t gainedKey = 2 * killerKey;
+
+				//! How many jumps every line searched by solve() may contain
+				static constexpr uint32_t solverJumps = 2;
+
+				//! solve() does not order the moves of statuses with at most that many empty fields
+				static constexpr uint32_t unsortedEmpty = 2;
+
+				//! Moves from this index on may be searched with reduced depth
+				static constexpr uint32_t lateMoveIndex = 3;
+
+				//! Moves from this index on are reduced by one level more
+				static constexpr uint32_t veryLateMoveIndex = 16;
+
+				//! Only nodes with at least this depth left reduce late moves
+				static constexpr uint32_t reductionDepth = 3;
+
+				//! How many levels less the move at index i is searched when depth levels are left
+				/*!
+				 * Moves are ordered best first, so the later a move comes, the less likely it is to raise alpha.
+				 * The reduced search always leaves at least one level.
+				 */
+				static uint32_t lateMoveReduction(const uint32_t i, const uint32_t depth) noexcept
+				{
+					if(depth < reductionDepth || i < lateMoveIndex) {
+						return 0;
+					}
+					const uint32_t reduction = i < veryLateMoveIndex ? 1 : 2;
+					return std::min(reduction, depth - 2);
+				}
+
+				//! The evaluation of the current status at ply from the point of view of the moving player
+				Score evaluate(const uint32_t ply) noexcept
+				{
+					++stats_.evaluations;
+					const auto score = network_ == nullptr || status_.gameOver() ? status_.evaluation() : network_->evaluate(plies_[ply].accumulator);
+					return status_.whiteMoves() ? score : - score;
+				}
+
+				//! What negamax() returns for the child of the current status at ply reached by m with no depth left, without making m
+				Score evaluateChild(const uint32_t ply, const Move m) noexcept
+				{
+					++nodes_;
+					pvLength_[ply + 1] = ply + 1;
+					if(stopping()) {
+						return 0;
+					}
+					++stats_.evaluations;
+					const auto score = status_.evaluationAfter(m);
+					// The opponent moves in the child.
+					return status_.whiteMoves() ? - score : score;
+				}
+
+				//! Try to refute the current status at ply with one level left before generating its moves
+				/*!
+				 * Most such statuses are refuted by the first move tried, which makes generating and ordering all moves the bulk of their work.
+				 * The moves tried are the one from the TranspositionTable, if it is legal, and a spawn gaining the most blobs,
+				 * found from the captures of every field the moving player can spawn to.
+				 * \param[out] score Receives the score of the refutation, or zero if the search was aborted
+				 * \param[out] m Receives the refutation
+				 * \return Whether a move reached beta or the search was aborted
+				 */
+				bool frontierCutoff(const uint32_t ply, const Move tableMove, const Score beta, Score & score, Move & m) noexcept
+				{
+					const auto own = status_.movingBlobs();
+					const auto opponent = status_.waitingBlobs();
+					const auto free = status_.empty();
+					std::array<Move, 2> candidates;
+					uint32_t len = 0;
+					if(!tableMove.isPass() && tableMove.to < Size * Size && tableMove.from < Size * Size && ((free >> tableMove.to) & 1)
+							&& (tableMove.isJump() ? ((own & detail::jumpMasks<Size>[tableMove.to]) >> tableMove.from) & 1
+								: (own & detail::neighbourMasks<Size>[tableMove.to]) != 0)) {
+						candidates[len++] = tableMove;
+					}
+					uint32_t bestCaptures = 0;
+					auto bestSpawn = Move::pass();
+					for(auto targets = detail::dilate<Size>(own) & free; targets != 0; ) {
+						const auto to = detail::popLowest(targets);
+						const auto captures = detail::popcount(detail::neighbourMasks<Size>[to] & opponent);
+						if(bestSpawn.isPass() || captures > bestCaptures) {
+							bestCaptures = captures;
+							bestSpawn = Move::spawn(to);
+						}
+					}
+					if(!bestSpawn.isPass() && (len == 0 || bestSpawn != candidates[0])) {
+						candidates[len++] = bestSpawn;
+					}
+					for(uint32_t i = 0; i != len; ++i) {
+						score = - evaluateChild(ply, candidates[i]);
+						if(aborted_) {
+							score = 0;
+							return true;
+						}
+						if(score >= beta) {
+							m = candidates[i];
+							countCutoff(i);
+							rememberCutoff(ply, 1, m);
+							return true;
+						}
+					}
+					return false;
+				}
+
+				//! Make a move of the current status at ply, updating the Accumulator of the next ply if a Network evaluates
+				Bitboard makeMove(const uint32_t ply, const Move m) noexcept
+				{
+					const auto whiteMoved = status_.whiteMoves();
+					const auto captured = status_.makeMove(m);
+					if(network_ != nullptr) {
+						network_->update(plies_[ply].accumulator, plies_[ply + 1].accumulator, whiteMoved, m, captured);
+					}
+					return captured;
+				}
+
+				//! Let the moving player of the current status at ply pass, see makeMove()
+				void pass(const uint32_t ply) noexcept
+				{
+					if(network_ != nullptr) {
+						network_->update(plies_[ply].accumulator, plies_[ply + 1].accumulator, status_.whiteMoves(), Move::pass(), 0);
+					}
+					status_.switchPlayerTurn();
+				}
+
+				//! Look up the current status in the Tablebase
+				/*!
+				 * A won status scores below the end of a game that is won, and one less for every empty field.
+				 * The Tablebase only knows who wins, so this is what makes the search fill the board rather than move between won statuses forever:
+				 * every spawn gets the winner closer to the end, while a jump does not.
+				 * \param[out] score Receives the score from the point of view of the moving player if the Tablebase knows it
+				 * \return Whether the Tablebase knows the status
+				 */
+				bool probeTablebase(Score & score) const noexcept
+				{
+					TablebaseResult result;
+					if(tablebase_ == nullptr || !tablebase_->probe(status_, result)) {
+						return false;
+					}
+					const auto win = (static_cast<Score>(Size * Size) - 1) * blobScore - static_cast<Score>(detail::popcount(status_.empty()));
+					score = result == TablebaseResult::Win ? win : result == TablebaseResult::Loss ? - win : 0;
+					return result != TablebaseResult::Unknown;
+				}
+
+				//! Whether the search has to stop
+				bool stopping() noexcept
+				{
+					if(!aborted_ && nodes_ % stopCheckInterval == 0
+							&& ((limits_->stop != nullptr && limits_->stop->load(std::memory_order_relaxed))
+								|| (limits_->nodes != 0 && nodes_ >= limits_->nodes)
+								|| (deadline_ != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline_))) {
+						aborted_ = true;
+					}
+					return aborted_;
+				}
+
+				//! Add a root move whose exact score was just searched to the ranked lines, dropping the last one if there are too many
+				void rankLine(const Move m, const Score score)
+				{
+					const auto at = std::find_if(lines_.begin(), lines_.end(), [score] (SearchLine const & line) { return line.score < score; });
+					auto & line = *lines_.insert(at, SearchLine{m, score, {}});
+					line.pv.push_back(m);
+					line.pv.insert(line.pv.end(), pv_[1].begin() + 1, pv_[1].begin() + pvLength_[1]);
+					if(lines_.size() > limits_->multiPv) {
+						lines_.pop_back();
+					}
+				}
+
+				//! Update the principal variation at ply after m turned out best
+				void updatePv(const uint32_t ply, const Move m) noexcept
+				{
+					pv_[ply][ply] = m;
+					std::copy(pv_[ply + 1].begin() + ply + 1, pv_[ply + 1].begin() + pvLength_[ply + 1], pv_[ply].begin() + ply + 1);
+					pvLength_[ply] = std::max(pvLength_[ply + 1], ply + 1);
+				}
+
+				//! Compute the keys of the moves at ply, the key of the best move being the highest
+				/*!
+				 * The principal variation move comes first, followed by the move from the TranspositionTable.
+				 * All other moves are ordered by the material they gain, where a spawn gains one blob more than a jump,
+				 * then by whether they are killer moves and then by their history.
+				 * A move taking the last blobs of the opponent always comes first.
+				 * \return Whether pvMove is among the moves
+				 */
+				bool orderMoves(const uint32_t ply, const uint32_t len, const Move tableMove, const Move pvMove) noexcept
+				{
+					auto & p = plies_[ply];
+					detail::captureCounts<Size>(status_.waitingBlobs(), p.moves.data(), len, p.captures.data());
+					const auto opponentBlobs = detail::popcount(status_.waitingBlobs());
+					auto const & history = history_[status_.whiteMoves() ? 0 : 1];
+					auto const & killers = killers_[ply];
+					bool pvFound = false;
+					for(uint32_t i = 0; i != len; ++i) {
+						const auto m = p.moves[i];
+						if(m == pvMove) {
+							p.keys[i] = INT32_MAX;
+							pvFound = true;
+						} else if(m == tableMove) {
+							p.keys[i] = INT32_MAX - 1;
+						} else if(p.captures[i] == opponentBlobs) {
+							p.keys[i] = INT32_MAX - 2;
+						} else {
+							const auto gained = 2 * static_cast<int32_t>(p.captures[i]) + (m.isJump() ? 0 : 1);
+							p.keys[i] = gained * gainedKey
+								+ (m == killers[0] || m == killers[1] ? killerKey : 0)
+								+ history[m.from * Size * Size + m.to];
+						}
+					}
+					return pvFound;
+				}
+
+				//! Count a beta cutoff by the move at index i
+				void countCutoff(const uint32_t i) noexcept
+				{
+					++stats_.cutoffs;
+					if(i == 0) {
+						++stats_.firstMoveCutoffs;
+					}
+				}
+
+				//! Remember a move that caused a beta cutoff in the killer and history tables
+				void rememberCutoff(const uint32_t ply, const uint32_t depth, const Move m) noexcept
+				{
+					auto & killers = killers_[ply];
+					if(killers[0] != m) {
+						killers[1] = killers[0];
+						killers[0] = m;
+					}
+					auto & history = history_[status_.whiteMoves() ? 0 : 1];
+					auto & h = history[m.from * Size * Size + m.to];
+					h += static_cast<int32_t>(depth * depth);
+					if(h >= killerKey) {
+						// Keep the history below the killer bonus by aging all entries.
+						for(auto & e : history) {
+							e /= 2;
+						}
+					}
+				}
+
+				//! Negamax search of the current status
+				/*!
+				 * \param[in] ply How far we descended into the tree, zero meaning that we're at the root
+				 * \param[in] depth How far we may still descend into the tree, zero meaning that we're at the deepest level
+				 * \return The score the current status receives from the point of view of the moving player
+				 */
+				Score negamax(const uint32_t ply, const uint32_t depth, Score alpha, Score beta) noexcept
+				{
+					++nodes_;
+					pvLength_[ply] = ply;
+					if(stopping()) {
+						return 0;
+					}
+					Score tablebaseScore;
+					if(ply != 0 && tablebase_ != nullptr && !status_.gameOver() && probeTablebase(tablebaseScore)) {
+						return tablebaseScore;
+					}
+					if(ply != 0 && detail::popcount(status_.empty()) <= limits_->endgameEmpty) {
+						return solve(ply, solverJumps, alpha, beta);
+					}
+					if(depth == 0 || status_.gameOver()) {
+						return evaluate(ply);
+					}
+
+					// See if we already know something about this status.
+					auto tableMove = Move::pass();
+					if(table_ != nullptr) {
+						TTEntry entry;
+						++stats_.tableProbes;
+						if(table_->probe(status_.key(), entry)) {
+							++stats_.tableHits;
+							tableMove = entry.move;
+							// At the root we need the best move, so we always search.
+							if(ply != 0 && entry.depth >= depth) {
+								if(entry.bound == Bound::Exact) {
+									return entry.score;
+								} else if(entry.bound == Bound::Lower) {
+									alpha = std::max(alpha, entry.score);
+								} else if(entry.bound == Bound::Upper) {
+									beta = std::min(beta, entry.score);
+								}
+								if(beta <= alpha) {
+									return entry.score;
+								}
+							}
+						}
+					}
+					const auto windowAlpha = alpha;
+
+					// When the children would only be evaluated, their evaluations are computed without making the moves.
+					const bool frontier = depth == 1 && ply != 0 && network_ == nullptr && tablebase_ == nullptr
+						&& detail::popcount(status_.empty()) > limits_->endgameEmpty + 1;
+					if(frontier && !followPv_) {
+						Score score;
+						Move m;
+						if(frontierCutoff(ply, tableMove, beta, score, m)) {
+							if(table_ != nullptr && !aborted_) {
+								table_->store(status_.key(), score, m, depth, Bound::Lower);
+							}
+							return score;
+						}
+					}
+
+					// First determine all possible moves right now.
+					auto & p = plies_[ply];
+					const auto len = generateMoves(status_, p.moves.begin());
+					assert(len <= p.moves.size());
+
+					if(len == 0) {
+						// The game is not over, so the moving player has to pass.
+						pass(ply);
+						const auto score = - negamax(ply + 1, depth - 1, - beta, - alpha);
+						status_.switchPlayerTurn();
+						if(!aborted_) {
+							updatePv(ply, Move::pass());
+						}
+						return score;
+					}
+
+					auto pvMove = Move::pass();
+					if(followPv_) {
+						if(ply < prevPvLength_) {
+							pvMove = prevPv_[ply];
+						} else {
+							followPv_ = false;
+						}
+					}
+					if(!orderMoves(ply, len, tableMove, pvMove)) {
+						followPv_ = false;
+					}
+					const bool multiPv = ply == 0 && limits_->multiPv > 1;
+					if(multiPv) {
+						// The ranking of the previous iteration is the best guess for this one.
+						for(uint32_t i = 0; i != len; ++i) {
+							const auto rank = std::find(prevLines_.begin(), prevLines_.end(), p.moves[i]) - prevLines_.begin();
+							if(static_cast<std::size_t>(rank) != prevLines_.size()) {
+								p.keys[i] = INT32_MAX - static_cast<int32_t>(rank);
+							}
+						}
+						lines_.clear();
+					}
+					if(ply == 0) {
+						// There is only one root, so we sort its moves right away.
+						for(uint32_t i = 0; i != len; ++i) {
+							detail::pickMove(p, i, len);
+						}
+					}
+					if(ply == 0 && id_ != 0 && len > 2) {
+						// Helpers search the root moves after the first one in differing orders.
+						std::rotate(p.moves.begin() + 1, p.moves.begin() + 1 + id_ % (len - 1), p.moves.begin() + len);
+					}
+
+					Score bestScore = - infinity;
+					uint32_t bestIndex = 0;
+					// Now descend one further for each possible move.
+					for(uint32_t i = 0; i != len; ++i) {
+						if(ply != 0) {
+							// Only select the next move when we actually need it.
+							detail::pickMove(p, i, len);
+						}
+						// With several principal variations, a root move has to beat the last ranked one rather than the best one.
+						const bool ranked = multiPv && lines_.size() == limits_->multiPv;
+						const auto moveAlpha = ranked ? std::max(lines_.back().score, windowAlpha) : multiPv ? windowAlpha : alpha;
+						Score score;
+						if(frontier) {
+							score = - evaluateChild(ply, p.moves[i]);
+						} else {
+							const auto captured = makeMove(ply, p.moves[i]);
+							if(i == 0 || (multiPv && !ranked)) {
+								score = - negamax(ply + 1, depth - 1, - beta, - moveAlpha);
+							} else {
+								// Later moves only have to be shown to be worse than the best one so far.
+								const auto reduction = limits_->reductions && limits_->multiPv <= 1 ? lateMoveReduction(i, depth) : 0;
+								score = - negamax(ply + 1, depth - 1 - reduction, - moveAlpha - 1, - moveAlpha);
+								if(score > moveAlpha && reduction != 0 && !aborted_) {
+									// Verify the fail high at full depth.
+									score = - negamax(ply + 1, depth - 1, - moveAlpha - 1, - moveAlpha);
+								}
+								if(score > moveAlpha && score < beta && !aborted_) {
+									// This might be the new best move, so we need its exact score.
+									score = - negamax(ply + 1, depth - 1, - beta, - moveAlpha);
+								}
+							}
+							status_.unmakeMove(p.moves[i], captured);
+						}
+						// Only the first move can continue the previous principal variation.
+						followPv_ = false;
+						if(aborted_) {
+							return 0;
+						}
+						if(multiPv && score > moveAlpha) {
+							rankLine(p.moves[i], score);
+						}
+						if(score > bestScore) {
+							bestScore = score;
+							bestIndex = i;
+							if(score > alpha) {
+								alpha = score;
+								updatePv(ply, p.moves[i]);
+								if(ply == 0) {
+									rootMove_ = p.moves[i];
+								}
+								if(alpha >= beta) {
+									countCutoff(i);
+									rememberCutoff(ply, depth, p.moves[i]);
+									break;
+								}
+							}
+						}
+					}
+					if(table_ != nullptr) {
+						const auto bound = bestScore <= windowAlpha ? Bound::Upper : bestScore >= beta ? Bound::Lower : Bound::Exact;
+						// When no move reached alpha, we don't know which one is best.
+						table_->store(status_.key(), bestScore, bound == Bound::Upper ? Move::pass() : p.moves[bestIndex], depth, bound);
+					}
+					return bestScore;
+				}
+
+				//! Solve the current status by searching every line to the end of the game
+				/*!
+				 * Used instead of negamax() once few empty fields are left, see SearchLimits::endgameEmpty.
+				 * Jumps do not fill the board, so a game could go on forever. Every line may therefore contain
+				 * only a limited number of jumps, and a status where only jumps are left beyond that is evaluated as it is.
+				 * Scores are only exact if no line below a status was cut off like this and no jump was left out of its moves;
+				 * only those are stored in the TranspositionTable, as deeper than any normal search, see guessed_.
+				 * A pass does not get a node of its own; the opponent's moves are searched right away.
+				 * \param[in] ply How far we descended into the tree
+				 * \param[in] jumps How many jumps the rest of the line may still contain
+				 * \return The score the current status receives from the point of view of the moving player
+				 */
+				Score solve(const uint32_t ply, const uint32_t jumps, Score alpha, Score beta) noexcept
+				{
+					++nodes_;
+					pvLength_[ply] = ply;
+					if(stopping()) {
+						return 0;
+					}
+					if(status_.gameOver()) {
+						return evaluate(ply);
+					}
+					if(ply + 2 >= maxDepth) {
+						guessed_ = true;
+						return evaluate(ply);
+					}
+					Score tablebaseScore;
+					if(probeTablebase(tablebaseScore)) {
+						return tablebaseScore;
+					}
+
+					const auto empty = status_.empty();
+					const auto emptyCount = detail::popcount(empty);
+					auto tableMove = Move::pass();
+					if(table_ != nullptr) {
+						TTEntry entry;
+						++stats_.tableProbes;
+						if(table_->probe(status_.key(), entry)) {
+							++stats_.tableHits;
+							tableMove = entry.move;
+							if(entry.depth >= maxDepth + jumps) {
+								if(entry.bound == Bound::Exact) {
+									return entry.score;
+								} else if(entry.bound == Bound::Lower) {
+									alpha = std::max(alpha, entry.score);
+								} else if(entry.bound == Bound::Upper) {
+									beta = std::min(beta, entry.score);
+								}
+								if(beta <= alpha) {
+									return entry.score;
+								}
+							}
+						}
+					}
+
+					uint32_t at = ply;
+					bool restricted = false;
+					auto len = solverMoves(at, jumps, restricted);
+					if(len == 0) {
+						if(generateMoves(status_, plies_[at].moves.begin()) != 0) {
+							// Only jumps are left, and this line may not contain any more.
+							guessed_ = true;
+							return evaluate(ply);
+						}
+						// The game is not over, so the opponent can move, which we search right here.
+						pass(ply);
+						at = ply + 1;
+						pvLength_[at] = at;
+						std::swap(alpha, beta);
+						alpha = - alpha;
+						beta = - beta;
+						len = solverMoves(at, jumps, restricted);
+						if(len == 0) {
+							status_.switchPlayerTurn();
+							guessed_ = true;
+							return evaluate(ply);
+						}
+					}
+					const auto windowAlpha = alpha;
+					// Whether a line below this status is cut off by the jump limit is only known for its own moves.
+					const bool outerGuessed = guessed_;
+					guessed_ = restricted;
+
+					auto & p = plies_[at];
+					const bool sorted = emptyCount > unsortedEmpty;
+					if(sorted) {
+						// Prefer gaining material, then filling regions with an odd number of empty fields,
+						// where we are likely to make the last move.
+						detail::captureCounts<Size>(status_.waitingBlobs(), p.moves.data(), len, p.captures.data());
+						const auto odd = oddRegions(empty);
+						for(uint32_t i = 0; i != len; ++i) {
+							const auto m = p.moves[i];
+							p.keys[i] = m == tableMove ? INT32_MAX :
+								static_cast<int32_t>(4 * p.captures[i] + (m.isJump() ? 0 : 2) + ((odd >> m.to) & 1));
+						}
+					}
+
+					Score bestScore = - infinity;
+					uint32_t bestIndex = 0;
+					for(uint32_t i = 0; i != len; ++i) {
+						if(sorted) {
+							detail::pickMove(p, i, len);
+						}
+						const auto m = p.moves[i];
+						Score score;
+						if(emptyCount == 1 && !m.isJump()) {
+							// Spawning to the last empty field ends the game, which we score without making the move.
+							++nodes_;
+							++stats_.evaluations;
+							const auto captured = static_cast<Score>(detail::popcount(detail::neighbourMasks<Size>[m.to] & status_.waitingBlobs()));
+							score = blobScore * detail::materialScore<Size>(
+									static_cast<Score>(detail::popcount(status_.movingBlobs())) + 1 + captured,
+									static_cast<Score>(detail::popcount(status_.waitingBlobs())) - captured,
+									0);
+							pvLength_[at + 1] = at + 1;
+						} else {
+							const auto captured = makeMove(at, m);
+							score = - solve(at + 1, m.isJump() ? jumps - 1 : jumps, - beta, - alpha);
+							status_.unmakeMove(m, captured);
+							if(aborted_) {
+								if(at != ply) {
+									status_.switchPlayerTurn();
+								}
+								return 0;
+							}
+						}
+						if(score > bestScore) {
+							bestScore = score;
+							bestIndex = i;
+							if(score > alpha) {
+								alpha = score;
+								updatePv(at, m);
+								if(alpha >= beta) {
+									countCutoff(i);
+									break;
+								}
+							}
+						}
+					}
+					if(table_ != nullptr && !guessed_) {
+						// Only proven results are stored as solved, a score that rests on an evaluation is not.
+						const auto bound = bestScore <= windowAlpha ? Bound::Upper : bestScore >= beta ? Bound::Lower : Bound::Exact;
+						table_->store(status_.key(), bestScore, bound == Bound::Upper ? Move::pass() : p.moves[bestIndex], maxDepth + jumps, bound);
+					}
+					guessed_ = guessed_ || outerGuessed;
+					if(at != ply) {
+						status_.switchPlayerTurn();
+						updatePv(ply, Move::pass());
+						return - bestScore;
+					}
+					return bestScore;
+				}
+
+				//! Generate the moves solve() searches at ply, which are only spawns if the line may not contain any more jumps
+				/*!
+				 * \param[out] restricted Whether any jump was left out
+				 */
+				uint32_t solverMoves(const uint32_t ply, const uint32_t jumps, bool & restricted) noexcept
+				{
+					auto & moves = plies_[ply].moves;
+					const auto len = generateMoves(status_, moves.begin());
+					if(jumps != 0) {
+						restricted = false;
+						return len;
+					}
+					const auto spawns = static_cast<uint32_t>(std::remove_if(moves.begin(), moves.begin() + len, [] (const Move m) { return m.isJump(); }) - moves.begin());
+					restricted = spawns != len;
+					return spawns;
+				}
+
+				//! All empty fields in regions of an odd number of adjacent empty fields
+				static Bitboard oddRegions(const Bitboard empty) noexcept
+				{
+					Bitboard r = 0;
+					for(auto rest = empty; rest != 0; ) {
+						Bitboard region = rest & (~rest + 1);
+						for(;;) {
+							const auto grown = detail::dilate<Size>(region) & empty;
+							if(grown == region) {
+								break;
+							}
+							region = grown;
+						}
+						rest &= ~region;
+						if(detail::popcount(region) % 2 != 0) {
+							r |= region;
+						}
+					}
+					return r;
+				}
+
+				//! Where results are stored and looked up, or nullptr
+				TranspositionTable * table_;
+
+				//! Where statuses below the root are looked up, or nullptr
+				Tablebase<Size> const * tablebase_;
+
+				//! What evaluates statuses instead of BasicStatus::evaluation(), or nullptr
+				Network<Size> const * network_;
+
+				//! Zero, or the number of the helper thread this Searcher runs in
+				uint32_t id_;
+
+				//! The scratch space of every level, indexed by the distance from the root
+				std::unique_ptr<detail::Ply<Size>[]> plies_;
+
+				//! The Status that all moves are made on
+				BasicStatus<Size> status_;
+
+				//! The limits of the running search
+				SearchLimits const * limits_ = nullptr;
+
+				//! When the running search has to stop, from SearchLimits::time
+				std::chrono::steady_clock::time_point deadline_;
+
+				//! The number of statuses visited in the running search
+				uint64_t nodes_ = 0;
+
+				//! What the running search did so far
+				SearchStats stats_;
+
+				//! Whether the running search was stopped
+				bool aborted_ = false;
+
+				//! The move at the root that raised alpha last in the running iteration, or Move::pass()
+				Move rootMove_ = Move::pass();
+
+				//! Triangular table of principal variations, the one starting at ply being stored in pv_[ply][ply, pvLength_[ply])
+				std::array<std::array<Move, maxDepth + 1>, maxDepth + 1> pv_;
+				std::array<uint32_t, maxDepth + 1> pvLength_;
+
+				//! The principal variation of the previous iteration
+				std::array<Move, maxDepth + 1> prevPv_;
+				uint32_t prevPvLength_ = 0;
+
+				//! Whether the current status is on the principal variation of the previous iteration
+				bool followPv_ = false;
+
+				//! Whether solve() evaluated a status whose game is not over or left out jumps since the innermost running solve() started its moves
+				bool guessed_ = false;
+
+				//! The best root moves of the running iteration with scores from the point of view of the moving player, see SearchLimits::multiPv
+				std::vector<SearchLine> lines_;
+
+				//! The moves of lines_ after the previous iteration, which are searched first in their order
+				std::vector<Move> prevLines_;
+
+				//! The last two moves that caused a beta cutoff at every ply
+				std::array<std::array<Move, 2>, maxDepth + 1> killers_;
+
+				//! How often every move caused beta cutoffs, weighted by depth, indexed by the player and from * fields + to
+				std::array<std::array<int32_t, Size * Size * Size * Size>, 2> history_;
+		};
+
+	template<uint32_t Size>
+		constexpr double BasicSearcher<Size>::maxTimeScale;
+	template<uint32_t Size>
+		constexpr double BasicSearcher<Size>::minGrowth;
+	template<uint32_t Size>
+		constexpr double BasicSearcher<Size>::maxGrowth;
+
+	//! The Searcher of the standard board
+	using Searcher = BasicSearcher<boardSize>;
+
+	//! Lazy SMP search running several Searchers on the same Status, sharing one TranspositionTable
+	/*!
+	 * The calling thread runs the main Searcher, whose result is returned.
+	 * The helper threads only contribute by filling the TranspositionTable, and are stopped as soon as the main Searcher is done.
+	 * Helpers differ from the main Searcher in the depths they search and the order of the root moves.
+	 */
+	template<uint32_t Size>
+		class BasicParallelSearcher
+		{
+			public:
+				/*!
+				 * \param[in] table The TranspositionTable shared by all threads, which should not be nullptr
+				 * \param[in] threads The total number of threads, including the calling one
+				 * \param[in] tablebase The Tablebase shared by all threads, or nullptr to not use one
+				 * \param[in] network The Network shared by all threads, or nullptr to use BasicStatus::evaluation()
+				 */
+				BasicParallelSearcher(TranspositionTable * table, const uint32_t threads, Tablebase<Size> const * tablebase = nullptr,
+						Network<Size> const * network = nullptr)
+				{
+					for(uint32_t i = 0; i != std::max(threads, 1U); ++i) {
+						searchers_.emplace_back(new BasicSearcher<Size>(table, i, tablebase, network));
+					}
+				}
+
+				//! The total number of threads, including the calling one
+				uint32_t threads() const noexcept
+				{
+					return static_cast<uint32_t>(searchers_.size());
+				}
+
+				//! Search a Status, see Searcher::search()
+				/*!
+				 * The number of nodes and the counters of the statistics in the result are the sums over all threads,
+				 * the iterations are those of the main Searcher.
+				 */
+				SearchResult search(BasicStatus<Size> const & status, SearchLimits const & limits)
+				{
+					std::atomic<bool> helpersStop{false};
+					SearchLimits helperLimits = limits;
+					helperLimits.stop = &helpersStop;
+					helperLimits.progress = nullptr;
+					// Helpers stop with the main Searcher.
+					helperLimits.softTime = std::chrono::steady_clock::duration::zero();
+					std::vector<SearchResult> helperResults(searchers_.size());
+					std::vector<std::thread> helpers;
+					for(std::size_t i = 1; i != searchers_.size(); ++i) {
+						helpers.emplace_back([this, i, &status, &helperLimits, &helperResults] {
+							helperResults[i] = searchers_[i]->search(status, helperLimits);
+						});
+					}
+					auto result = searchers_[0]->search(status, limits);
+					helpersStop.store(true, std::memory_order_relaxed);
+					for(auto & helper : helpers) {
+						helper.join();
+					}
+					for(auto const & helperResult : helperResults) {
+						result.nodes += helperResult.nodes;
+						result.stats += helperResult.stats;
+					}
+					return result;
+				}
+
+			private:
+				//! The main Searcher followed by the helpers
+				std::vector<std::unique_ptr<BasicSearcher<Size>>> searchers_;
+		};
+
+	//! The ParallelSearcher of the standard board
+	using ParallelSearcher = BasicParallelSearcher<boardSize>;
+}
+
+#endif
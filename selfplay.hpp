@@ -0,0 +1,322 @@
+/*!
+ * \file atasol_selfplay.hpp
+ * \brief atasol self-play games as training data
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_SELFPLAY_HPP_
+#define ATASOL_SELFPLAY_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "mapping.hpp"
+#include "nnue.hpp"
+#include "search.hpp"
+#include "solver.hpp"
+#include "tablebase.hpp"
+
+namespace atasol {
+	namespace detail {
+		//! The white and black fields of every byte of five base 3 digits, see SelfPlayRecord::board
+		struct TritBytes
+		{
+			uint8_t white[243];
+			uint8_t black[243];
+		};
+
+		constexpr TritBytes makeTritBytes() noexcept
+		{
+			TritBytes r{};
+			for(uint32_t byte = 0; byte != 243; ++byte) {
+				uint32_t rest = byte;
+				for(uint32_t bit = 0; bit != 5; ++bit, rest /= 3) {
+					if(rest % 3 == 1) {
+						r.white[byte] = static_cast<uint8_t>(r.white[byte] | (1 << bit));
+					} else if(rest % 3 == 2) {
+						r.black[byte] = static_cast<uint8_t>(r.black[byte] | (1 << bit));
+					}
+				}
+			}
+			return r;
+		}
+
+		constexpr TritBytes tritBytes = makeTritBytes();
+	}
+
+	//! One Status of a self-play game with what the search and the end of the game said about it
+	template<uint32_t Size>
+		struct SelfPlayRecord
+		{
+			//! The score the search found, positive values being good for white as with BasicStatus::evaluation()
+			int16_t score;
+
+			//! The number of moves made in the game before, including the random opening
+			uint16_t ply;
+
+			//! The result of the game, which is BasicStatus::score() of its last Status, or zero if the game was cut off after SelfPlayFile::maxPlies moves
+			int8_t result;
+
+			//! One if black moves, zero if white moves
+			uint8_t blackMoves;
+
+			//! The fields in groups of five, every byte being a base 3 number with digits 0 for empty or blocked, 1 for white and 2 for black
+			/*!
+			 * The first field of a group is the lowest digit. The size is rounded up to an even number of bytes, so that there is no padding.
+			 */
+			std::array<uint8_t, ((Size * Size + 4) / 5 + 1) / 2 * 2> board;
+
+			//! Pack a Status
+			static SelfPlayRecord pack(BasicStatus<Size> const & status, const Score score, const uint32_t ply) noexcept
+			{
+				SelfPlayRecord r{};
+				r.score = static_cast<int16_t>(score);
+				r.ply = static_cast<uint16_t>(std::min<uint32_t>(ply, UINT16_MAX));
+				r.blackMoves = status.blackMoves() ? 1 : 0;
+				auto white = status.white();
+				auto black = status.black();
+				for(std::size_t i = 0; white != 0 || black != 0; ++i, white >>= 5, black >>= 5) {
+					r.board[i] = static_cast<uint8_t>(detail::ternaryBytes[white & 0x1f] + 2 * detail::ternaryBytes[black & 0x1f]);
+				}
+				return r;
+			}
+
+			//! Unpack the Status
+			/*!
+			 * \param[in] blocked The blocked fields of the game, see SelfPlayFile::blocked()
+			 */
+			BasicStatus<Size> status(const Bitboard blocked) const noexcept
+			{
+				BasicStatus<Size> r;
+				for(uint32_t pos = 0; pos != Size * Size; ++pos) {
+					const auto byte = board[pos / 5];
+					const auto bit = pos % 5;
+					if(((blocked >> pos) & 1) != 0) {
+						r.set(pos, Entry::Blocked);
+					} else if(byte < 243 && ((detail::tritBytes.white[byte] >> bit) & 1) != 0) {
+						r.set(pos, Entry::White);
+					} else if(byte < 243 && ((detail::tritBytes.black[byte] >> bit) & 1) != 0) {
+						r.set(pos, Entry::Black);
+					}
+				}
+				if(blackMoves != 0) {
+					r.switchPlayerTurn();
+				}
+				return r;
+			}
+		};
+
+	//! What generateSelfPlay() produced
+	struct SelfPlayCounts
+	{
+		uint64_t games = 0;
+		uint64_t positions = 0;
+		uint64_t whiteWins = 0;
+		uint64_t blackWins = 0;
+		uint64_t draws = 0;
+
+		//! The games among the draws that were cut off after SelfPlayFile::maxPlies moves rather than ending
+		uint64_t cutOff = 0;
+	};
+
+	//! A file of SelfPlayRecord structs, as written by generate()
+	/*!
+	 * The file is a header with the blocked fields of all games, followed by the records in the byte order of the machine that wrote it.
+	 * It is mapped into memory and read in place, so opening even a file of hundreds of millions of records does not read or parse anything.
+	 */
+	template<uint32_t Size>
+		class SelfPlayFile
+		{
+			public:
+				using Record = SelfPlayRecord<Size>;
+
+				static_assert(std::is_trivially_copyable<Record>::value && sizeof(Record) == 6 + sizeof(Record::board), "SelfPlayRecord is stored as it is.");
+
+				//! Map a file written by generate(), replacing any file opened before
+				/*!
+				 * \return Whether path holds records of this board size
+				 */
+				bool open(std::string const & path)
+				{
+					if(!file_.open(path)) {
+						return false;
+					}
+					if(file_.size() < headerSize || (file_.size() - headerSize) % sizeof(Record) != 0
+							|| std::memcmp(file_.data(), header().data(), header().size()) != 0) {
+						file_.close();
+						return false;
+					}
+					return true;
+				}
+
+				//! Whether a file is open
+				bool isOpen() const noexcept
+				{
+					return file_.data() != nullptr;
+				}
+
+				//! The number of records
+				std::size_t size() const noexcept
+				{
+					return isOpen() ? (file_.size() - headerSize) / sizeof(Record) : 0;
+				}
+
+				//! The blocked fields of all games
+				Bitboard blocked() const noexcept
+				{
+					Bitboard r = 0;
+					if(isOpen()) {
+						std::memcpy(&r, file_.data() + header().size(), sizeof(r));
+					}
+					return r;
+				}
+
+				//! The record at an index below size()
+				Record operator[](const std::size_t i) const noexcept
+				{
+					// The mapped bytes are not Record objects, so each one is copied out of them.
+					Record r;
+					std::memcpy(&r, file_.data() + headerSize + i * sizeof(Record), sizeof(r));
+					return r;
+				}
+
+				//! Play games of computer players against each other and write all their statuses to a file
+				/*!
+				 * Every thread plays one game at a time with its own Searcher and a share of the TranspositionTable memory.
+				 * A game starts with random moves, chosen with a seed derived from the number of the game,
+				 * and then records every Status before each move with the score of its search.
+				 * Once the game is over, or after maxPlies moves since jumps can go on forever, its records are written with its result.
+				 * A game that was cut off counts as a draw, as the blobs it ended with say little about who would have won.
+				 * \param[in] start The Status every game starts from, whose blocked fields are stored in the header
+				 * \param[in] games The number of games
+				 * \param[in] openingPlies The number of random moves at the start of every game, which are not recorded
+				 * \param[in] limits The limits of every search
+				 * \param[in] threads The number of games played at once
+				 * \param[in] hashMegabytes The size of all TranspositionTables together
+				 * \param[in] path The file to write
+				 * \param[out] counts Receives what was written
+				 * \param[in] seed Where the random openings come from
+				 * \param[in] network The Network that evaluates statuses, or nullptr to use BasicStatus::evaluation()
+				 * \return Whether the file was written
+				 */
+				static bool generate(BasicStatus<Size> const & start, const uint64_t games, const uint32_t openingPlies, SearchLimits const & limits,
+						const uint32_t threads, const std::size_t hashMegabytes, std::string const & path, SelfPlayCounts & counts,
+						const uint64_t seed = 0, Network<Size> const * network = nullptr)
+				{
+					std::ofstream file(path, std::ios::binary | std::ios::trunc);
+					file.write(header().data(), static_cast<std::streamsize>(header().size()));
+					const Bitboard blocked = start.blocked();
+					file.write(reinterpret_cast<char const *>(&blocked), static_cast<std::streamsize>(sizeof(blocked)));
+					std::mutex fileMutex;
+					counts = SelfPlayCounts();
+
+					std::atomic<uint64_t> nextGame{0};
+					const auto workerCount = std::max(threads, 1U);
+					const auto work = [&] {
+						TranspositionTable table(std::max<std::size_t>(hashMegabytes / workerCount, 1));
+						BasicSearcher<Size> searcher(&table, 0, nullptr, network);
+						std::vector<Record> records;
+						std::array<Move, upperLimitMoves<Size>> moves;
+						for(;;) {
+							const auto game = nextGame.fetch_add(1);
+							if(game >= games) {
+								return;
+							}
+							std::mt19937_64 random(seed ^ (game * 0x9e3779b97f4a7c15ULL));
+							BasicStatus<Size> status;
+							uint32_t ply;
+							do {
+								// Start over if the random moves end the game.
+								status = start;
+								for(ply = 0; ply != openingPlies && !status.gameOver(); ++ply) {
+									const auto len = generateMoves(status, moves.begin());
+									status.play(len == 0 ? Move::pass() : moves[random() % len]);
+								}
+							} while(status.gameOver() && !start.gameOver());
+
+							records.clear();
+							for(; !status.gameOver() && ply != maxPlies; ++ply) {
+								const auto result = searcher.search(status, limits);
+								records.push_back(Record::pack(status, result.score, ply));
+								status.play(result.move);
+							}
+							const bool cutOff = !status.gameOver();
+							const auto result = cutOff ? 0 : status.score();
+							for(auto & record : records) {
+								record.result = static_cast<int8_t>(result);
+							}
+
+							std::lock_guard<std::mutex> lock(fileMutex);
+							file.write(reinterpret_cast<char const *>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+							++counts.games;
+							counts.positions += records.size();
+							++(result > 0 ? counts.whiteWins : result < 0 ? counts.blackWins : counts.draws);
+							if(cutOff) {
+								++counts.cutOff;
+							}
+						}
+					};
+
+					std::vector<std::thread> workers;
+					for(uint32_t i = 1; i < workerCount; ++i) {
+						workers.emplace_back(work);
+					}
+					work();
+					for(auto & worker : workers) {
+						worker.join();
+					}
+					return static_cast<bool>(file);
+				}
+
+				//! Games are ended after that many moves, because jumps alone can go on forever
+				static constexpr uint32_t maxPlies = 1000;
+
+			private:
+				//! The size of the header, which is "atasolsp" followed by the board size as a digit, padding and the blocked fields
+				static constexpr std::size_t headerSize = 16 + sizeof(Bitboard);
+
+				static std::array<char, 16> header() noexcept
+				{
+					std::array<char, 16> r{{'a', 't', 'a', 's', 'o', 'l', 's', 'p', static_cast<char>('0' + Size)}};
+					return r;
+				}
+
+				//! The header followed by the records
+				MappedFile file_;
+		};
+}
+
+#endif
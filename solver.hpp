@@ -34,590 +34,1224 @@
 
 #include <algorithm>
 #include <array>
-#include <sstream>
+#include <atomic>
+#include <memory>
+#include <new>
 #include <string>
+#include <tuple>
 #include <utility>
 
+#if defined(__AVX2__) && !defined(ATASOL_NO_AVX2)
+#define ATASOL_AVX2
+#include <immintrin.h>
+#endif
+
 namespace atasol {
-	//! The size of the game board.  Defaults to 7 since normally a 7x7 board is used.
+	//! The size of the standard game board, which Status and all other types and functions default to
 	static constexpr uint32_t boardSize = 7;
 
-	static_assert(boardSize > 2, "Board Size must be at least 3.");
-
 	using Score = int32_t;
 
-	//! The underlying storage size.
-	using Storage = std::size_t;
+	//! How much a blob is worth in BasicStatus::evaluation(), so that positional features can be worth a fraction of a blob
+	constexpr Score blobScore = 16;
 
-	//! The three possible states of each field
+	//! One bit per field of the board, field i * size + j being bit i * size + j
+	using Bitboard = uint64_t;
+
+	//! The three possible states of each field, and the state of a field no blob may ever enter
 	enum class Entry
 	{
 		Empty = 0,
 		White = 1,
 		Black = 2,
+		Blocked = 3,
 	};
 
 	namespace detail {
-		// The game itself is played on an boardSize * boardSize board, with each Entry having three possible values.
-		// We just use 2 bits per such state, allowing for an unused fourth value.
-		// Furthermore, we want one bit to represent if it's the first or the second player's turn.
-		constexpr uint32_t bitsNeeded = boardSize * boardSize * 2 + 1;
-		constexpr uint32_t bitsPerStorage = sizeof(Storage) * 8;
-		constexpr uint32_t storagesNeeded = bitsNeeded / bitsPerStorage + (bitsNeeded % bitsPerStorage != 0);
-	}
+		//! All fields of a board of the given size
+		template<uint32_t Size>
+			constexpr Bitboard boardMask = Size * Size == sizeof(Bitboard) * 8 ? ~Bitboard{0} : (Bitboard{1} << (Size * Size)) - 1;
 
-	// An upper bound for the number of possible moves of one player.
-	// Used so that we don't have to do dynamic memory allocation.
-	// TODO: This could be tweaked further by doing some thinking.
-	constexpr uint32_t upperLimitMoves =
-		boardSize * boardSize // One blob may be created in at most every empty space
-		+ boardSize * boardSize * 16 // Every blob may jump to at most 16 other spaces
-		;
-
-	//! The status of a game
-	class Status
-	{
-		public:
-			constexpr Status() :
-				storages_{} {}
+		//! One Bitboard per field
+		template<uint32_t Size>
+			struct FieldMasks
+			{
+				Bitboard masks[Size * Size];
 
-			constexpr bool whiteMoves() const noexcept { return (storages_[storages_.size() - 1] & (1UL << (detail::bitsPerStorage - 1))) == 0; }
-			constexpr bool blackMoves() const noexcept { return (storages_[storages_.size() - 1] & (1UL << (detail::bitsPerStorage - 1))) != 0; }
+				constexpr Bitboard operator[](uint32_t pos) const noexcept { return masks[pos]; }
+			};
 
-			constexpr Entry movingPlayer() const noexcept { return whiteMoves() ? Entry::White : Entry::Black; }
+		//! Compute for every field the mask of all fields at exactly the given king-move distance
+		template<uint32_t Size>
+			constexpr FieldMasks<Size> makeRingMasks(const uint32_t distance) noexcept
+			{
+				FieldMasks<Size> r{};
+				for(uint32_t i = 0; i != Size; ++i) {
+					for(uint32_t j = 0; j != Size; ++j) {
+						Bitboard m = 0;
+						for(uint32_t k = 0; k != Size; ++k) {
+							for(uint32_t l = 0; l != Size; ++l) {
+								const auto di = i > k ? i - k : k - i;
+								const auto dj = j > l ? j - l : l - j;
+								if((di > dj ? di : dj) == distance) {
+									m |= Bitboard{1} << (k * Size + l);
+								}
+							}
+						}
+						r.masks[i * Size + j] = m;
+					}
+				}
+				return r;
+			}
+
+		//! The fields a blob may be spawned to from a field, which are also the fields it captures
+		template<uint32_t Size>
+			constexpr FieldMasks<Size> neighbourMasks = makeRingMasks<Size>(1);
+
+		//! The fields a blob may jump to from a field
+		template<uint32_t Size>
+			constexpr FieldMasks<Size> jumpMasks = makeRingMasks<Size>(2);
 
-			//! Switch to the other player
-			void switchPlayerTurn() noexcept { storages_[storages_.size() - 1] ^= (1UL << (detail::bitsPerStorage - 1)); }
+		inline uint32_t popcount(const Bitboard b) noexcept
+		{
+			return static_cast<uint32_t>(__builtin_popcountll(b));
+		}
 
-			//! Access individual entry
-			constexpr Entry operator[](uint32_t pos) const noexcept
+		//! Remove the lowest field from a non-empty Bitboard and return it
+		inline uint32_t popLowest(Bitboard & b) noexcept
+		{
+			assert(b != 0);
+			const auto r = static_cast<uint32_t>(__builtin_ctzll(b));
+			b &= b - 1;
+			return r;
+		}
+
+		//! All fields of one column
+		template<uint32_t Size>
+			constexpr Bitboard makeColumnMask(const uint32_t col) noexcept
 			{
-				assert(pos < boardSize * boardSize);
-				pos *= 2;
-				const auto index = pos / detail::bitsPerStorage;
-				const auto relPos = pos - index * detail::bitsPerStorage;
-				const Storage bitmask = 3UL << relPos;
-				assert(index < storages_.size());
-				return static_cast<Entry>((storages_[index] & bitmask) >> relPos);
+				Bitboard r = 0;
+				for(uint32_t i = 0; i != Size; ++i) {
+					r |= Bitboard{1} << (i * Size + col);
+				}
+				return r;
 			}
 
-			//! Set an individual entry
-			void set(const uint32_t pos, const Entry value = Entry::Empty) noexcept
+		template<uint32_t Size>
+			constexpr Bitboard notFirstColumn = boardMask<Size> & ~makeColumnMask<Size>(0);
+		template<uint32_t Size>
+			constexpr Bitboard notLastColumn = boardMask<Size> & ~makeColumnMask<Size>(Size - 1);
+
+		//! All fields at king-move distance at most one from a field of b
+		/*!
+		 * Blocked fields are not taken into account, as blobs may jump over them.
+		 */
+		template<uint32_t Size>
+			constexpr Bitboard dilate(const Bitboard b) noexcept
 			{
-				const auto v = operator[](pos);
-				if(v == value) {
-					return;
-				}
-				if(v == Entry::White) {
-					--whiteScore_;
-				} else if(v == Entry::Black) {
-					--blackScore_;
-				}
-				if(value == Entry::White) {
-					++whiteScore_;
-				} else if(value == Entry::Black) {
-					++blackScore_;
-				}
-				setNoScoreAdjust(pos, value);
+				const Bitboard h = b | ((b << 1) & notFirstColumn<Size>) | ((b >> 1) & notLastColumn<Size>);
+				return (h | (h << Size) | (h >> Size)) & boardMask<Size>;
 			}
 
-			//! Put a blob at an entry, making the surrounding entries of opponent color change color
-			/*!
-			 * This function spawns a blob at coordinates (i, j) of the current player.
-			 * It alters all surrounding blobs under opponent control to the current player's color.
-			 * It then changes the current player.
-			 */
-			void spawn(uint32_t i, uint32_t j) noexcept
+		//! The number of symmetries of a square board
+		/*!
+		 * Symmetry s mirrors the columns if bit 1 is set, then the rows if bit 0 is set, and then swaps rows and columns if bit 2 is set,
+		 * which gives the four rotations and the four reflections.
+		 */
+		constexpr uint32_t symmetries = 8;
+
+		//! Where every field goes under every symmetry, and where it comes from
+		template<uint32_t Size>
+			struct SymmetryFields
 			{
-				assert(i < boardSize);
-				assert(j < boardSize);
-				// Current player
-				const auto cp = movingPlayer();
-				setNoScoreAdjust(i * boardSize + j, cp);
-				if(whiteMoves()) {
-					++whiteScore_;
-				} else {
-					++blackScore_;
-				}
-				switchPlayerTurn();
-				// Next player
-				const auto np = movingPlayer();
-				if(i > 0) {
-					if(j > 0 && operator[]((i - 1) * boardSize + j - 1) == np) {
-						set((i - 1) * boardSize + j - 1, cp);
-					}
-					if(operator[]((i - 1) * boardSize + j) == np) {
-						set((i - 1) * boardSize + j, cp);
-					}
-					if(j < boardSize - 1 && operator[]((i - 1) * boardSize + j + 1) == np) {
-						set((i - 1) * boardSize + j + 1, cp);
+				uint8_t to[symmetries][Size * Size];
+				uint8_t from[symmetries][Size * Size];
+			};
+
+		template<uint32_t Size>
+			constexpr SymmetryFields<Size> makeSymmetryFields() noexcept
+			{
+				SymmetryFields<Size> r{};
+				for(uint32_t s = 0; s != symmetries; ++s) {
+					for(uint32_t i = 0; i != Size; ++i) {
+						for(uint32_t j = 0; j != Size; ++j) {
+							const auto row = (s & 1) ? Size - 1 - i : i;
+							const auto col = (s & 2) ? Size - 1 - j : j;
+							const auto pos = (s & 4) ? col * Size + row : row * Size + col;
+							r.to[s][i * Size + j] = static_cast<uint8_t>(pos);
+							r.from[s][pos] = static_cast<uint8_t>(i * Size + j);
+						}
 					}
 				}
-				if(j > 0 && operator[](i * boardSize + j - 1) == np) {
-					set(i * boardSize + j - 1, cp);
-				}
-				if(j < boardSize - 1 && operator[](i * boardSize + j + 1) == np) {
-					set(i * boardSize + j + 1, cp);
-				}
-				if(i < boardSize - 1) {
-					if(j > 0 && operator[]((i + 1) * boardSize + j - 1) == np) {
-						set((i + 1) * boardSize + j - 1, cp);
-					}
-					if(operator[]((i + 1) * boardSize + j) == np) {
-						set((i + 1) * boardSize + j, cp);
-					}
-					if(j < boardSize - 1 && operator[]((i + 1) * boardSize + j + 1) == np) {
-						set((i + 1) * boardSize + j + 1, cp);
+				return r;
+			}
+
+		template<uint32_t Size>
+			constexpr SymmetryFields<Size> symmetryFields = makeSymmetryFields<Size>();
+
+		//! Every row of Size fields, both as it is and mirrored, placed as a column at the left edge of the board
+		template<uint32_t Size>
+			struct RowTables
+			{
+				uint8_t mirrored[1U << Size];
+				Bitboard column[1U << Size];
+			};
+
+		template<uint32_t Size>
+			constexpr RowTables<Size> makeRowTables() noexcept
+			{
+				RowTables<Size> r{};
+				for(uint32_t row = 0; row != (1U << Size); ++row) {
+					for(uint32_t j = 0; j != Size; ++j) {
+						if((row >> j) & 1) {
+							r.mirrored[row] = static_cast<uint8_t>(r.mirrored[row] | (1U << (Size - 1 - j)));
+							r.column[row] |= Bitboard{1} << (j * Size);
+						}
 					}
 				}
+				return r;
 			}
 
-			//! Compute the score
-			/*!
-			 * The score is simply the sum over all f(e) for every entry e, where
-			 * f(black) = -1, f(white) = 1, f(empty) = 0.
-			 * However, when the board is full or white or black have no blobs left, the score is +- infinity.
-			 */
-			Score score() const noexcept
+		template<uint32_t Size>
+			constexpr RowTables<Size> rowTables = makeRowTables<Size>();
+
+		//! Move every field of a Bitboard where a symmetry takes it, a row at a time
+		template<uint32_t Size>
+			Bitboard transform(const Bitboard b, const uint32_t symmetry) noexcept
 			{
-#ifndef NDEBUG
-				Score w = 0, b = 0;
-				for(uint32_t i = 0; i != boardSize * boardSize; ++i) {
-					const auto v = operator[](i);
-					if(v == Entry::Black) {
-						++b;
-					} else if(v == Entry::White) {
-						++w;
+				assert(symmetry < symmetries);
+				Bitboard r = 0;
+				for(uint32_t i = 0; i != Size; ++i) {
+					auto row = static_cast<uint32_t>(b >> (i * Size)) & ((1U << Size) - 1);
+					if(symmetry & 2) {
+						row = rowTables<Size>.mirrored[row];
 					}
+					const auto target = (symmetry & 1) ? Size - 1 - i : i;
+					r |= (symmetry & 4) ? rowTables<Size>.column[row] << target : Bitboard{row} << (target * Size);
 				}
-				assert(w == whiteScore_);
-				assert(b == blackScore_);
-#endif
-				if(blackScore_ == 0) {
+				return r;
+			}
+
+		//! The score of a board with the given number of blobs and empty fields, see BasicStatus::score()
+		template<uint32_t Size>
+			constexpr Score materialScore(const Score whiteScore, const Score blackScore, const Score emptyFields) noexcept
+			{
+				if(blackScore == 0) {
 					// Black lost.
-					return static_cast<Score>(boardSize * boardSize);
-				} else if(whiteScore_ == 0) {
+					return static_cast<Score>(Size * Size);
+				} else if(whiteScore == 0) {
 					// White lost.
-					return - static_cast<Score>(boardSize * boardSize);
-				} else if(whiteScore_ + blackScore_ == boardSize * boardSize) {
+					return - static_cast<Score>(Size * Size);
+				} else if(emptyFields == 0) {
 					// The board is full, so the winner takes it all.
-					if(whiteScore_ > blackScore_) {
-						return boardSize * boardSize;
-					} else if(blackScore_ > whiteScore_) {
-						return - static_cast<Score>(boardSize * boardSize);
+					if(whiteScore > blackScore) {
+						return Size * Size;
+					} else if(blackScore > whiteScore) {
+						return - static_cast<Score>(Size * Size);
 					}
 				}
-				return whiteScore_ - blackScore_;
+				return whiteScore - blackScore;
 			}
 
-			//! Convert this Status to string
-			template<class CharT = char,
-				class Traits = std::char_traits<CharT>,
-				class Allocator = std::allocator<CharT>>
-					std::basic_string<CharT, Traits, Allocator> to_string(CharT empty = CharT('E'), CharT white = CharT('W'), CharT black = CharT('B')) const
-					{
-						std::basic_string<CharT, Traits, Allocator> r;
-						constexpr std::size_t size = (4 + boardSize * 2 + 1) * (boardSize + 3);
-						r.reserve(size);
-						{
-							r += "  | ";
-							char col = 'A';
-							for(uint32_t i = 0; i != boardSize; ++i) {
-								r += col;
-								r += ' ';
-								++col;
-							}
-							r += '\n';
-						}
-						r += "--+-";
-						for(uint32_t i = 0; i != boardSize; ++i) {
-							r += "--";
-						}
-						r += '\n';
-						char row = '0';
-						for(uint32_t i = 0; i != boardSize; ++i) {
-							r += row;
-							++row;
-							r += " | ";
-							for(uint32_t j = 0; j != boardSize; ++j) {
-								const auto v = operator[](i * boardSize + j);
-								r += v == Entry::Empty ? empty :
-									v == Entry::White ? white :
-									black;
-								r += ' ';
-							}
-							r += '\n';
-						}
-						r += "--+-";
-						for(uint32_t i = 0; i != boardSize; ++i) {
-							r += "--";
-						}
-						r += '\n';
-						r += "  | Score: ";
-						{
-							std::stringstream ss;
-							ss << score();
-							r += ss.str();
-						}
-						r += '\n';
-						return r;
-					}
+		//! One Score per field
+		template<uint32_t Size>
+			struct FieldScores
+			{
+				Score scores[Size * Size];
 
-		private:
-			//! The status as a bit field
-			std::array<Storage, detail::storagesNeeded> storages_;
+				constexpr Score operator[](uint32_t pos) const noexcept { return scores[pos]; }
+			};
 
-			//! The current score of white
-			Score whiteScore_ = 0;
+		//! How hard a blob on every field is to capture, which is the number of neighbours it lacks compared to an inner field
+		/*!
+		 * A blob in a corner can only be captured from three fields and one on an edge from five,
+		 * which makes them more likely to survive until the end of the game.
+		 */
+		template<uint32_t Size>
+			constexpr FieldScores<Size> makeStabilityScores() noexcept
+			{
+				FieldScores<Size> r{};
+				for(uint32_t i = 0; i != Size; ++i) {
+					for(uint32_t j = 0; j != Size; ++j) {
+						const auto rows = 1 + (i != 0 ? 1 : 0) + (i != Size - 1 ? 1 : 0);
+						const auto cols = 1 + (j != 0 ? 1 : 0) + (j != Size - 1 ? 1 : 0);
+						r.scores[i * Size + j] = 9 - rows * cols;
+					}
+				}
+				return r;
+			}
 
-			//! The current score of black
-			Score blackScore_ = 0;
+		template<uint32_t Size>
+			constexpr FieldScores<Size> stabilityScores = makeStabilityScores<Size>();
 
-			//! Set an individual entry without adjusting score
-			void setNoScoreAdjust(uint32_t pos, const Entry value) noexcept
+		//! Count the pairs of neighbouring fields with one field in a and the other one in b
+		/*!
+		 * Each of the eight directions is shifted on its own, so that a field of b next to several fields of a counts once per pair.
+		 */
+		template<uint32_t Size>
+			uint32_t neighbourPairs(const Bitboard a, const Bitboard b) noexcept
 			{
-				assert(pos < boardSize * boardSize);
-				pos *= 2;
-				const auto index = pos / detail::bitsPerStorage;
-				const auto relPos = pos - index * detail::bitsPerStorage;
-				const Storage bitmask = 3UL << relPos;
-				assert(index < storages_.size());
-				storages_[index] &= ~bitmask;
-				storages_[index] |= static_cast<Storage>(value) << relPos;
+				const Bitboard left = (a << 1) & notFirstColumn<Size>;
+				const Bitboard right = (a >> 1) & notLastColumn<Size>;
+				return popcount(left & b) + popcount(right & b)
+					+ popcount((a << Size) & b) + popcount((left << Size) & b) + popcount((right << Size) & b)
+					+ popcount((a >> Size) & b) + popcount((left >> Size) & b) + popcount((right >> Size) & b);
 			}
 
-			friend bool operator==(Status const & lhs, Status const & rhs) noexcept
+		//! Limit an estimate to stay below the score of any won game, including those a search gets from a Tablebase
+		template<uint32_t Size>
+			constexpr Score clampEstimate(const Score estimate) noexcept
 			{
-				assert(lhs.storages_ != rhs.storages_ || (lhs.whiteScore_ == rhs.whiteScore_ && lhs.blackScore_ == rhs.blackScore_));
-				return lhs.storages_ == rhs.storages_;
+				constexpr Score limit = static_cast<Score>(Size * Size - 1) * blobScore - 1;
+				return estimate < - limit ? - limit : estimate > limit ? limit : estimate;
 			}
+
+		//! The weights of the features of BasicStatus::evaluation(), in the units of blobScore
+		//! \{
+		constexpr Score stabilityWeight = 2;
+		constexpr Score mobilityWeight = 2;
+		constexpr Score exposureWeight = 3;
+		constexpr Score holeWeight = 6;
+		//! \}
+
+		//! One step of the splitmix64 generator, used to fill the Zobrist tables at compile time
+		constexpr uint64_t splitmix64(uint64_t & state) noexcept
+		{
+			state += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = state;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);
+		}
+
+		//! Random keys for every blob or block on every field and for black to move, which a Status key is the xor of
+		template<uint32_t Size>
+			struct ZobristKeys
+			{
+				uint64_t white[Size * Size];
+				uint64_t black[Size * Size];
+				uint64_t blocked[Size * Size];
+				uint64_t blackMoves;
+			};
+
+		//! Generate the keys of one board size, which differ from those of every other size
+		template<uint32_t Size>
+			constexpr ZobristKeys<Size> makeZobristKeys() noexcept
+			{
+				ZobristKeys<Size> r{};
+				uint64_t state = 0x617461736f6c0000ULL | Size;
+				for(uint32_t i = 0; i != Size * Size; ++i) {
+					r.white[i] = splitmix64(state);
+					r.black[i] = splitmix64(state);
+				}
+				r.blackMoves = splitmix64(state);
+				for(uint32_t i = 0; i != Size * Size; ++i) {
+					r.blocked[i] = splitmix64(state);
+				}
+				return r;
+			}
+
+		template<uint32_t Size>
+			constexpr ZobristKeys<Size> zobrist = makeZobristKeys<Size>();
+	}
+
+	// An upper bound for the number of possible moves of one player.
+	// Used so that we don't have to do dynamic memory allocation.
+	// With e empty fields and p = Size * Size - e blobs of the moving player, there are at most e spawns,
+	// and at most 16 * min(e, p) jumps since every jump needs both a blob to leave and an empty field to land on.
+	// This is maximal for e = ceil(Size * Size / 2), and blocked fields only lower it.
+	template<uint32_t Size>
+		constexpr uint32_t upperLimitMoves =
+			(Size * Size + 1) / 2 // One blob may be created in at most every empty space
+			+ (Size * Size / 2) * 16 // Every blob may jump to at most 16 other spaces
+			;
+
+	//! A single move of the moving player
+	/*!
+	 * A blob either spawns at the empty field to, or it jumps from the field from to the empty field to.
+	 * Spawns are encoded with from == to.
+	 * If the moving player has no moves at all, the turn passes, which is encoded with the special Move pass().
+	 */
+	struct Move
+	{
+		uint8_t from;
+		uint8_t to;
+
+		//! Marks the fields of pass()
+		static constexpr uint8_t noField = 0xff;
+
+		static constexpr Move spawn(const uint32_t to) noexcept { return Move{static_cast<uint8_t>(to), static_cast<uint8_t>(to)}; }
+		static constexpr Move jump(const uint32_t from, const uint32_t to) noexcept { return Move{static_cast<uint8_t>(from), static_cast<uint8_t>(to)}; }
+		static constexpr Move pass() noexcept { return Move{noField, noField}; }
+
+		constexpr bool isJump() const noexcept { return from != to; }
+		constexpr bool isPass() const noexcept { return to == noField; }
+
+		friend constexpr bool operator==(const Move lhs, const Move rhs) noexcept { return lhs.from == rhs.from && lhs.to == rhs.to; }
+		friend constexpr bool operator!=(const Move lhs, const Move rhs) noexcept { return !(lhs == rhs); }
 	};
 
-	//! Generate all possible moves
+	//! The status of a game on a board of Size x Size fields, some of which may be blocked
 	/*!
-	 * This function generates all possibles new Status that may result from an existing Status.
-	 * \tparam Iter The type of the output iterator
-	 * \param[in] start The initial Status from which to start
-	 * \param[in] output The output iterator that is written to, must be sufficiently large to hold all generated Statuses
-	 * \return The number of Statuses generated
+	 * Every board size is a separate type, so that all masks and tables are compile time constants.
+	 * Blocked fields can neither hold a blob nor be moved to, but blobs may jump over them.
+	 * They are set like blobs and stay for the whole game.
 	 */
-	template<typename Iter>
-		uint32_t generateStatuses(Status const & start, Iter output) noexcept
+	template<uint32_t Size>
+		class BasicStatus
 		{
-			uint32_t num = 0;
-			const auto movingPlayer = start.movingPlayer();
-			for(uint32_t i = 0; i != boardSize; ++i) {
-				for(uint32_t j = 0; j != boardSize; ++j) {
-					if(start[i * boardSize + j] != Entry::Empty) {
-						// Entry must still be empty.
-						continue;
+			static_assert(Size > 2, "Board Size must be at least 3.");
+			static_assert(Size * Size <= sizeof(Bitboard) * 8, "The board must fit into a single Bitboard.");
+			static_assert(Size * Size <= Move::noField, "Fields must be representable in a Move.");
+
+			public:
+				//! The number of fields in every row and column
+				static constexpr uint32_t size = Size;
+
+				//! The number of fields of the board, including blocked ones
+				static constexpr uint32_t fields = Size * Size;
+
+				constexpr BasicStatus() noexcept {}
+
+				constexpr bool whiteMoves() const noexcept { return !blackMoves_; }
+				constexpr bool blackMoves() const noexcept { return blackMoves_; }
+
+				constexpr Entry movingPlayer() const noexcept { return whiteMoves() ? Entry::White : Entry::Black; }
+
+				//! Switch to the other player
+				void switchPlayerTurn() noexcept
+				{
+					blackMoves_ = !blackMoves_;
+					key_ ^= detail::zobrist<Size>.blackMoves;
+				}
+
+				//! The Zobrist key, which is updated incrementally by every change
+				constexpr uint64_t key() const noexcept { return key_; }
+
+				//! The fields occupied by white
+				constexpr Bitboard white() const noexcept { return white_; }
+
+				//! The fields occupied by black
+				constexpr Bitboard black() const noexcept { return black_; }
+
+				//! The fields that are blocked
+				constexpr Bitboard blocked() const noexcept { return blocked_; }
+
+				//! The fields that are still empty
+				constexpr Bitboard empty() const noexcept { return ~(white_ | black_ | blocked_) & detail::boardMask<Size>; }
+
+				//! The fields occupied by the moving player
+				constexpr Bitboard movingBlobs() const noexcept { return whiteMoves() ? white_ : black_; }
+
+				//! The fields occupied by the player that is not moving
+				constexpr Bitboard waitingBlobs() const noexcept { return whiteMoves() ? black_ : white_; }
+
+				//! Access individual entry
+				constexpr Entry operator[](const uint32_t pos) const noexcept
+				{
+					assert(pos < fields);
+					return ((blocked_ >> pos) & 1) ? Entry::Blocked : static_cast<Entry>(((white_ >> pos) & 1) | (((black_ >> pos) & 1) << 1));
+				}
+
+				//! Set an individual entry
+				void set(const uint32_t pos, const Entry value = Entry::Empty) noexcept
+				{
+					assert(pos < fields);
+					const Bitboard bit = Bitboard{1} << pos;
+					if(white_ & bit) {
+						key_ ^= detail::zobrist<Size>.white[pos];
+					} else if(black_ & bit) {
+						key_ ^= detail::zobrist<Size>.black[pos];
+					} else if(blocked_ & bit) {
+						key_ ^= detail::zobrist<Size>.blocked[pos];
 					}
-					// First, go through all possibilities to spawn a new blob from an existing one.
-					// Check that at least one neighboring entry is of type movingPlayer
-					if(
-							(i > 0 && (
-								   (start[(i - 1) * boardSize + j] == movingPlayer) ||
-								   (j > 0 && start[(i - 1) * boardSize + j - 1] == movingPlayer) ||
-								   (j < boardSize - 1 && start[(i - 1) * boardSize + j + 1] == movingPlayer)
-								  )) ||
-							((
-							  (j > 0 && start[i * boardSize + j - 1] == movingPlayer) ||
-							  (j < boardSize - 1 && start[i * boardSize + j + 1] == movingPlayer)
-							 )) ||
-							(i < boardSize - 1 && (
-									       (start[(i + 1) * boardSize + j] == movingPlayer) ||
-									       (j > 0 && start[(i + 1) * boardSize + j - 1] == movingPlayer) ||
-									       (j < boardSize - 1 && start[(i + 1) * boardSize + j + 1] == movingPlayer)
-									      ))
-					  ) {
-						// There is a neighboring blob that the one at (i, j) could be spawned from.
-						auto copy = start;
-						copy.spawn(i, j);
-						*output = copy;
-						++output;
-						++num;
+					if(white_ & bit) {
+						stability_ -= detail::stabilityScores<Size>[pos];
+					} else if(black_ & bit) {
+						stability_ += detail::stabilityScores<Size>[pos];
 					}
-					// Next, check if an existing blob can jump to the given position.
-					// For every such possibility, we need to append an individual Status.
-					if(i > 1) {
-						// Check if a blob can jump in from two rows above.
-						if(j > 0) {
-							if(j > 1 && start[(i - 2) * boardSize + j - 2] == movingPlayer) {
-								auto copy = start;
-								copy.set((i - 2) * boardSize + j - 2);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
-							}
-							if(start[(i - 2) * boardSize + j - 1] == movingPlayer) {
-								auto copy = start;
-								copy.set((i - 2) * boardSize + j - 1);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
-							}
-						}
-						if(start[(i - 2) * boardSize + j] == movingPlayer) {
-							auto copy = start;
-							copy.set((i - 2) * boardSize + j);
-							copy.spawn(i, j);
-							*output = copy;
-							++output;
-							++num;
-						}
-						if(j < boardSize - 1) {
-							if(start[(i - 2) * boardSize + j + 1] == movingPlayer) {
-								auto copy = start;
-								copy.set((i - 2) * boardSize + j + 1);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
-							}
-							if(j < boardSize - 2 && start[(i - 2) * boardSize + j + 2] == movingPlayer) {
-								auto copy = start;
-								copy.set((i - 2) * boardSize + j + 2);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
-							}
-						}
+					white_ &= ~bit;
+					black_ &= ~bit;
+					blocked_ &= ~bit;
+					if(value == Entry::White) {
+						white_ |= bit;
+						key_ ^= detail::zobrist<Size>.white[pos];
+						stability_ += detail::stabilityScores<Size>[pos];
+					} else if(value == Entry::Black) {
+						black_ |= bit;
+						key_ ^= detail::zobrist<Size>.black[pos];
+						stability_ -= detail::stabilityScores<Size>[pos];
+					} else if(value == Entry::Blocked) {
+						blocked_ |= bit;
+						key_ ^= detail::zobrist<Size>.blocked[pos];
 					}
-					if(i > 0) {
-						// Check if a blob can jump in from one above and two to the left or right.
-						if(j > 1 && start[(i - 1) * boardSize + j - 2] == movingPlayer) {
-							auto copy = start;
-							copy.set((i - 1) * boardSize + j - 2);
-							copy.spawn(i, j);
-							*output = copy;
-							++output;
-							++num;
-						}
-						if(j < boardSize - 2 && start[(i - 1) * boardSize + j + 2] == movingPlayer) {
-							auto copy = start;
-							copy.set((i - 1) * boardSize + j + 2);
-							copy.spawn(i, j);
-							*output = copy;
-							++output;
-							++num;
+				}
+
+				//! The Status with every field moved where a symmetry takes it, see detail::symmetries
+				BasicStatus transformed(const uint32_t symmetry) const noexcept
+				{
+					BasicStatus r = *this;
+					r.white_ = detail::transform<Size>(white_, symmetry);
+					r.black_ = detail::transform<Size>(black_, symmetry);
+					r.blocked_ = detail::transform<Size>(blocked_, symmetry);
+					r.key_ = r.computeKey();
+					// Symmetric fields have the same stability score, so stability_ stays.
+					return r;
+				}
+
+				//! The symmetry that transforms the Status into the representative of all statuses symmetric to it
+				/*!
+				 * The representative is the one with the lowest white fields, then black fields, then blocked fields,
+				 * so symmetric statuses have the same representative and its key() can stand for all of them.
+				 */
+				uint32_t canonicalSymmetry() const noexcept
+				{
+					uint32_t best = 0;
+					auto bestFields = std::make_tuple(white_, black_, blocked_);
+					for(uint32_t s = 1; s != detail::symmetries; ++s) {
+						const auto candidate = std::make_tuple(detail::transform<Size>(white_, s), detail::transform<Size>(black_, s), detail::transform<Size>(blocked_, s));
+						if(candidate < bestFields) {
+							best = s;
+							bestFields = candidate;
 						}
 					}
-					// Check if a blob can jump in from two to the left or to the right.
-					if(j > 1 && start[i * boardSize + j - 2] == movingPlayer) {
-						auto copy = start;
-						copy.set(i * boardSize + j - 2);
-						copy.spawn(i, j);
-						*output = copy;
-						++output;
-						++num;
+					return best;
+				}
+
+				//! The representative of all statuses symmetric to this one, see canonicalSymmetry()
+				BasicStatus canonical() const noexcept
+				{
+					return transformed(canonicalSymmetry());
+				}
+
+				//! Put a blob at an entry, making the surrounding entries of opponent color change color
+				/*!
+				 * This function spawns a blob at coordinates (i, j) of the current player.
+				 * It alters all surrounding blobs under opponent control to the current player's color.
+				 * It then changes the current player.
+				 */
+				void spawn(uint32_t i, uint32_t j) noexcept
+				{
+					assert(i < Size);
+					assert(j < Size);
+					makeMove(Move::spawn(i * Size + j));
+				}
+
+				//! Make a move of the current player and change the current player
+				/*!
+				 * \param[in] m The move, which must not be a pass
+				 * \return The blobs that changed color, which unmakeMove() needs to take the move back
+				 */
+				Bitboard makeMove(const Move m) noexcept
+				{
+					assert(!m.isPass());
+					assert(m.to < fields);
+					assert(operator[](m.to) == Entry::Empty);
+					assert(operator[](m.from) == (m.isJump() ? movingPlayer() : Entry::Empty));
+					const Bitboard captured = detail::neighbourMasks<Size>[m.to] & waitingBlobs();
+					toggleMove(m, captured);
+					switchPlayerTurn();
+					return captured;
+				}
+
+				//! Make any move including a pass, when the blobs that changed color are not needed
+				void play(const Move m) noexcept
+				{
+					if(m.isPass()) {
+						switchPlayerTurn();
+					} else {
+						makeMove(m);
 					}
-					if(j < boardSize - 2 && start[i * boardSize + j + 2] == movingPlayer) {
-						auto copy = start;
-						copy.set(i * boardSize + j + 2);
-						copy.spawn(i, j);
-						*output = copy;
-						++output;
-						++num;
+				}
+
+				//! Take back a move made by makeMove()
+				/*!
+				 * \param[in] m The move that was made
+				 * \param[in] captured The return value of makeMove()
+				 */
+				void unmakeMove(const Move m, const Bitboard captured) noexcept
+				{
+					switchPlayerTurn();
+					toggleMove(m, captured);
+				}
+
+				//! Whether the game is over, because a player has no blobs left or no player can move anymore
+				constexpr bool gameOver() const noexcept
+				{
+					return white_ == 0 || black_ == 0 || (detail::dilate<Size>(detail::dilate<Size>(white_ | black_)) & empty()) == 0;
+				}
+
+				//! Compute the score
+				/*!
+				 * The score is simply the sum over all f(e) for every entry e, where
+				 * f(black) = -1, f(white) = 1, f(empty) = f(blocked) = 0.
+				 * However, when the board is full or white or black have no blobs left, the score is +- infinity.
+				 */
+				Score score() const noexcept
+				{
+					assert((white_ & black_) == 0);
+					assert(((white_ | black_) & blocked_) == 0);
+					assert(((white_ | black_ | blocked_) & ~detail::boardMask<Size>) == 0);
+					assert(key_ == computeKey());
+					return detail::materialScore<Size>(static_cast<Score>(detail::popcount(white_)), static_cast<Score>(detail::popcount(black_)), static_cast<Score>(detail::popcount(empty())));
+				}
+
+				//! Estimate the score, in units of blobScore
+				/*!
+				 * Once the game is over, this is score() times blobScore. Before, the material is corrected by positional features
+				 * that favour each player with a weight from detail:
+				 * - the stability of its blobs on corners and edges, see detail::stabilityScores, which is kept up to date by every change,
+				 * - its mobility, the number of empty fields it can spawn to,
+				 * - less exposure, the number of its blobs next to an empty field the opponent can reach,
+				 * - fewer holes, the number of its blobs next to each empty field the opponent can spawn to, which that spawn would capture.
+				 *
+				 * Estimates stay below the score of any won game, see detail::clampEstimate().
+				 */
+				Score evaluation() const noexcept
+				{
+					assert(stability_ == computeStability());
+					return evaluation(white_, black_, blocked_, stability_);
+				}
+
+				//! The evaluation() of the Status after a move, computed from the fields it leaves without making it
+				/*!
+				 * This is cheaper than makeMove(), evaluation() and unmakeMove(), since the key does not change,
+				 * which lets searches evaluate the moves of their last level in one go.
+				 * \param[in] m The move, which must not be a pass
+				 */
+				Score evaluationAfter(const Move m) const noexcept
+				{
+					assert(!m.isPass());
+					const Bitboard to = Bitboard{1} << m.to;
+					const Bitboard captured = detail::neighbourMasks<Size>[m.to] & waitingBlobs();
+					const auto own = (movingBlobs() ^ (((Bitboard{1} << m.from) ^ to) | to)) | captured;
+					const auto opponent = waitingBlobs() ^ captured;
+					Score stability = detail::stabilityScores<Size>[m.to];
+					if(m.isJump()) {
+						stability -= detail::stabilityScores<Size>[m.from];
 					}
-					if(i < boardSize - 1) {
-						// Check if a blob can jump in from one row below and two to the left or right.
-						if(j > 1 && start[(i + 1) * boardSize + j - 2] == movingPlayer) {
-							auto copy = start;
-							copy.set((i + 1) * boardSize + j - 2);
-							copy.spawn(i, j);
-							*output = copy;
-							++output;
-							++num;
-						}
-						if(j < boardSize - 2 && start[(i + 1) * boardSize + j + 2] == movingPlayer) {
-							auto copy = start;
-							copy.set((i + 1) * boardSize + j + 2);
-							copy.spawn(i, j);
-							*output = copy;
-							++output;
-							++num;
-						}
+					for(auto c = captured; c != 0; ) {
+						stability += 2 * detail::stabilityScores<Size>[detail::popLowest(c)];
 					}
-					if(i < boardSize - 2) {
-						// Check if a blob can jump in from the row two below.
-						if(j > 0) {
-							if(j > 1 && start[(i + 2) * boardSize + j - 2] == movingPlayer) {
-								auto copy = start;
-								copy.set((i + 2) * boardSize + j - 2);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
+					return whiteMoves() ? evaluation(own, opponent, blocked_, stability_ + stability) : evaluation(opponent, own, blocked_, stability_ - stability);
+				}
+
+				//! Convert this Status to string
+				template<class CharT = char,
+					class Traits = std::char_traits<CharT>,
+					class Allocator = std::allocator<CharT>>
+						std::basic_string<CharT, Traits, Allocator> to_string(CharT empty = CharT('E'), CharT white = CharT('W'), CharT black = CharT('B'), CharT blocked = CharT('#')) const
+						{
+							std::basic_string<CharT, Traits, Allocator> r;
+							constexpr std::size_t stringSize = (4 + Size * 2 + 1) * (Size + 3);
+							r.reserve(stringSize);
+							{
+								r += "  | ";
+								char col = 'A';
+								for(uint32_t i = 0; i != Size; ++i) {
+									r += col;
+									r += ' ';
+									++col;
+								}
+								r += '\n';
 							}
-							if(start[(i + 2) * boardSize + j - 1] == movingPlayer) {
-								auto copy = start;
-								copy.set((i + 2) * boardSize + j - 1);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
+							r += "--+-";
+							for(uint32_t i = 0; i != Size; ++i) {
+								r += "--";
 							}
-						}
-						if(start[(i + 2) * boardSize + j] == movingPlayer) {
-							auto copy = start;
-							copy.set((i + 2) * boardSize + j);
-							copy.spawn(i, j);
-							*output = copy;
-							++output;
-							++num;
-						}
-						if(j < boardSize - 1) {
-							if(start[(i + 2) * boardSize + j + 1] == movingPlayer) {
-								auto copy = start;
-								copy.set((i + 2) * boardSize + j + 1);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
+							r += '\n';
+							char row = '0';
+							for(uint32_t i = 0; i != Size; ++i) {
+								r += row;
+								++row;
+								r += " | ";
+								for(uint32_t j = 0; j != Size; ++j) {
+									const auto v = operator[](i * Size + j);
+									r += v == Entry::Empty ? empty :
+										v == Entry::White ? white :
+										v == Entry::Black ? black :
+										blocked;
+									r += ' ';
+								}
+								r += '\n';
 							}
-							if(j < boardSize - 2 && start[(i + 2) * boardSize + j + 2] == movingPlayer) {
-								auto copy = start;
-								copy.set((i + 2) * boardSize + j + 2);
-								copy.spawn(i, j);
-								*output = copy;
-								++output;
-								++num;
+							r += "--+-";
+							for(uint32_t i = 0; i != Size; ++i) {
+								r += "--";
 							}
+							r += '\n';
+							r += "  | Score: ";
+							r += std::to_string(score());
+							r += '\n';
+							return r;
+						}
+
+			private:
+				//! The evaluation() of the given fields, see there
+				static Score evaluation(const Bitboard white, const Bitboard black, const Bitboard blocked, const Score stability) noexcept
+				{
+					const auto free = ~(white | black | blocked) & detail::boardMask<Size>;
+					if(white == 0 || black == 0 || (detail::dilate<Size>(detail::dilate<Size>(white | black)) & free) == 0) {
+						return detail::materialScore<Size>(static_cast<Score>(detail::popcount(white)), static_cast<Score>(detail::popcount(black)),
+								static_cast<Score>(detail::popcount(free))) * blobScore;
+					}
+					const auto whiteSpawns = detail::dilate<Size>(white) & free;
+					const auto blackSpawns = detail::dilate<Size>(black) & free;
+					const auto whiteReach = detail::dilate<Size>(whiteSpawns | white) & free;
+					const auto blackReach = detail::dilate<Size>(blackSpawns | black) & free;
+					const auto mobility = static_cast<Score>(detail::popcount(whiteSpawns)) - static_cast<Score>(detail::popcount(blackSpawns));
+					const auto exposure = static_cast<Score>(detail::popcount(white & detail::dilate<Size>(blackReach)))
+						- static_cast<Score>(detail::popcount(black & detail::dilate<Size>(whiteReach)));
+					const auto holes = static_cast<Score>(detail::neighbourPairs<Size>(white, blackSpawns))
+						- static_cast<Score>(detail::neighbourPairs<Size>(black, whiteSpawns));
+					const auto material = static_cast<Score>(detail::popcount(white)) - static_cast<Score>(detail::popcount(black));
+					const auto r = material * blobScore + detail::stabilityWeight * stability + detail::mobilityWeight * mobility
+						- detail::exposureWeight * exposure - detail::holeWeight * holes;
+					return detail::clampEstimate<Size>(r);
+				}
+
+				//! The fields occupied by white
+				Bitboard white_ = 0;
+
+				//! The fields occupied by black
+				Bitboard black_ = 0;
+
+				//! The fields no blob may enter
+				Bitboard blocked_ = 0;
+
+				//! Whether it is black's turn
+				bool blackMoves_ = false;
+
+				//! The Zobrist key of the fields and the player to move
+				uint64_t key_ = 0;
+
+				//! The sum of detail::stabilityScores over all white blobs minus that over all black blobs
+				Score stability_ = 0;
+
+				//! Apply or take back the changes of a move to the blobs of the moving player, who stays the same
+				void toggleMove(const Move m, const Bitboard captured) noexcept
+				{
+					auto & own = whiteMoves() ? white_ : black_;
+					auto & opponent = whiteMoves() ? black_ : white_;
+					const auto ownKeys = whiteMoves() ? detail::zobrist<Size>.white : detail::zobrist<Size>.black;
+					const auto opponentKeys = whiteMoves() ? detail::zobrist<Size>.black : detail::zobrist<Size>.white;
+					const Bitboard to = Bitboard{1} << m.to;
+					// For a spawn this just toggles to, for a jump it also toggles from.
+					own ^= ((Bitboard{1} << m.from) ^ to) | to | captured;
+					opponent ^= captured;
+					key_ ^= ownKeys[m.to];
+					Score stability = detail::stabilityScores<Size>[m.to];
+					if(m.isJump()) {
+						key_ ^= ownKeys[m.from];
+						stability -= detail::stabilityScores<Size>[m.from];
+					}
+					for(auto c = captured; c != 0; ) {
+						const auto pos = detail::popLowest(c);
+						key_ ^= ownKeys[pos] ^ opponentKeys[pos];
+						stability += 2 * detail::stabilityScores<Size>[pos];
+					}
+					// The move was made if the moving player now has a blob on to, and taken back otherwise.
+					stability_ += ((own & to) != 0) == whiteMoves() ? stability : - stability;
+				}
+
+				//! Compute the Zobrist key from scratch
+				uint64_t computeKey() const noexcept
+				{
+					uint64_t r = blackMoves_ ? detail::zobrist<Size>.blackMoves : 0;
+					for(uint32_t i = 0; i != fields; ++i) {
+						if((white_ >> i) & 1) {
+							r ^= detail::zobrist<Size>.white[i];
+						} else if((black_ >> i) & 1) {
+							r ^= detail::zobrist<Size>.black[i];
+						} else if((blocked_ >> i) & 1) {
+							r ^= detail::zobrist<Size>.blocked[i];
 						}
 					}
+					return r;
+				}
+
+				//! Compute stability_ from scratch
+				Score computeStability() const noexcept
+				{
+					Score r = 0;
+					for(uint32_t i = 0; i != fields; ++i) {
+						if((white_ >> i) & 1) {
+							r += detail::stabilityScores<Size>[i];
+						} else if((black_ >> i) & 1) {
+							r -= detail::stabilityScores<Size>[i];
+						}
+					}
+					return r;
+				}
+
+				friend bool operator==(BasicStatus const & lhs, BasicStatus const & rhs) noexcept
+				{
+					assert(lhs.key_ == lhs.computeKey());
+					assert(rhs.key_ == rhs.computeKey());
+					return lhs.white_ == rhs.white_ && lhs.black_ == rhs.black_ && lhs.blocked_ == rhs.blocked_ && lhs.blackMoves_ == rhs.blackMoves_;
+				}
+		};
+
+	template<uint32_t Size>
+		constexpr uint32_t BasicStatus<Size>::size;
+	template<uint32_t Size>
+		constexpr uint32_t BasicStatus<Size>::fields;
+
+	//! The status of a game on the standard board
+	using Status = BasicStatus<boardSize>;
+
+	//! The Move of a Status that a symmetry turns into the same Move of the transformed Status
+	template<uint32_t Size>
+		constexpr Move transformMove(const Move m, const uint32_t symmetry) noexcept
+		{
+			return m.isPass() ? m : Move{detail::symmetryFields<Size>.to[symmetry][m.from], detail::symmetryFields<Size>.to[symmetry][m.to]};
+		}
+
+	//! Take a Move of a transformed Status back to the Status it was transformed from, undoing transformMove()
+	template<uint32_t Size>
+		constexpr Move restoreMove(const Move m, const uint32_t symmetry) noexcept
+		{
+			return m.isPass() ? m : Move{detail::symmetryFields<Size>.from[symmetry][m.from], detail::symmetryFields<Size>.from[symmetry][m.to]};
+		}
+
+	//! The Status a game starts with, having a blob of each player in two opposite corners and white to move
+	template<uint32_t Size = boardSize>
+		BasicStatus<Size> startingStatus() noexcept
+		{
+			BasicStatus<Size> status;
+			status.set(0 * Size + 0, Entry::White);
+			status.set(0 * Size + Size - 1, Entry::Black);
+			status.set((Size - 1) * Size + 0, Entry::Black);
+			status.set((Size - 1) * Size + Size - 1, Entry::White);
+			return status;
+		}
+
+	//! Generate all possible moves
+	/*!
+	 * This function generates all possible moves of the moving player in an existing Status.
+	 * A pass is not generated, so no moves being generated means that the moving player has to pass.
+	 * Moves are ordered by the field they lead to, with the spawn to a field preceding the jumps to it.
+	 * \tparam Iter The type of the output iterator
+	 * \param[in] start The initial Status from which to start
+	 * \param[in] output The output iterator that is written to, must be sufficiently large to hold upperLimitMoves<Size> Moves
+	 * \return The number of Moves generated
+	 */
+	template<uint32_t Size, typename Iter>
+		uint32_t generateMoves(BasicStatus<Size> const & start, Iter output) noexcept
+		{
+			uint32_t num = 0;
+			const auto own = start.movingBlobs();
+			const auto empty = start.empty();
+			// All empty fields next to a blob of the moving player, which a blob may be spawned to.
+			const auto spawnTargets = detail::dilate<Size>(own) & empty;
+			// All empty fields that can be reached at all.
+			auto targets = detail::dilate<Size>(detail::dilate<Size>(own)) & empty;
+			while(targets != 0) {
+				const auto to = detail::popLowest(targets);
+				if((spawnTargets >> to) & 1) {
+					*output = Move::spawn(to);
+					++output;
+					++num;
+				}
+				// Every blob on the ring around to may jump there.
+				auto sources = detail::jumpMasks<Size>[to] & own;
+				while(sources != 0) {
+					*output = Move::jump(detail::popLowest(sources), to);
+					++output;
+					++num;
 				}
 			}
 			return num;
 		}
 
-	//! Apply the minimax algorithm to all moves below a given Status
+	//! What a score stored in the TranspositionTable means
+	enum class Bound : uint8_t
+	{
+		None = 0, //!< Nothing is stored
+		Upper = 1, //!< The real score is at most the stored score
+		Lower = 2, //!< The real score is at least the stored score
+		Exact = 3, //!< The stored score is the real score
+	};
+
+	//! What the TranspositionTable knows about a Status
+	struct TTEntry
+	{
+		Score score;
+		//! The best move found, or Move::pass() if none is known
+		Move move;
+		//! How many levels below the Status were searched to obtain score
+		uint32_t depth;
+		Bound bound;
+	};
+
+	//! Fixed size hash table of search results, indexed by Status::key()
 	/*!
-	 * Example call: minimax<4>(status, n)
-	 * This will descend from status 4 levels deep, eveluating minimax, and save the next status to be assumed into n.
-	 * n may point to status.
+	 * Entries are grouped into buckets of one cache line each, so a probe touches a single cache line.
+	 * When a bucket is full, the entry that was searched least deep is replaced, where entries of older searches
+	 * count as searched less deep.
 	 *
-	 * \tparam depth The total depth that will be searched
-	 * \param[in] status The Status we will explore further
-	 * \param[in] nextStatus Pointer that the next status is written to in order to achieve this score, or nullptr if it shouldn't be written
-	 * \param[in] level How far we descended into the tree, zero meaning that we're at the deepest level
-	 * \return The score status receives, given that we descend level more levels into the tree
+	 * Several threads may probe and store concurrently without locking:
+	 * every entry is two relaxed atomic words, the key being stored xor the data,
+	 * so an entry torn by a concurrent store does not match any key and is ignored.
 	 */
-	template<uint32_t depth>
-		Score minimax(Status const& status, Status * nextStatus = nullptr, const uint32_t level = depth, Score alpha = - static_cast<Score>(boardSize * boardSize), Score beta = static_cast<Score>(boardSize * boardSize))
-		{
-			if(level == 0) {
-				return status.score();
+	class TranspositionTable
+	{
+		public:
+			explicit TranspositionTable(const std::size_t megabytes = 16)
+			{
+				resize(megabytes);
 			}
 
-			// First determine all possible moves right now.
-			std::array<Status, upperLimitMoves> moves;
-			const auto len = generateStatuses(status, moves.begin());
-			assert(len < moves.size());
+			//! Change the size to the largest power of two number of buckets fitting into the given size, and clear the table
+			void resize(const std::size_t megabytes)
+			{
+				std::size_t buckets = 1;
+				while(buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+					buckets *= 2;
+				}
+				memory_.reset();
+				memory_.reset(new char[buckets * sizeof(Bucket) + alignof(Bucket)]);
+				void * p = memory_.get();
+				std::size_t space = buckets * sizeof(Bucket) + alignof(Bucket);
+				buckets_ = static_cast<Bucket *>(std::align(alignof(Bucket), buckets * sizeof(Bucket), p, space));
+				for(std::size_t i = 0; i != buckets; ++i) {
+					new (buckets_ + i) Bucket;
+				}
+				mask_ = buckets - 1;
+				clear();
+			}
 
-			if(len == 0) {
-				// There are no further moves to be explored.
-				if(nextStatus != nullptr) {
-					// So we change turns and return the same status since no move can be made.
-					Status copy(status);
-					copy.switchPlayerTurn();
-					*nextStatus = std::move(copy);
+			//! Remove all entries, which must not happen during a search
+			void clear() noexcept
+			{
+				for(std::size_t i = 0; i != mask_ + 1; ++i) {
+					for(auto & slot : buckets_[i].slots) {
+						slot.check.store(0, std::memory_order_relaxed);
+						slot.data.store(0, std::memory_order_relaxed);
+					}
 				}
-				// So the score of status is just that, its score.
-				return status.score();
+				generation_.store(0, std::memory_order_relaxed);
 			}
 
-			// Whether we are maximizing (or minimizing)
-			const bool maximizing = status.whiteMoves();
+			//! Start a new search, which makes all existing entries older
+			void newSearch() noexcept
+			{
+				generation_.store((generation_.load(std::memory_order_relaxed) + 1) & generationMask, std::memory_order_relaxed);
+			}
 
-			// We sort everything but the first level.
-			// This heuristic proves to have the best performance.
-			if(level != depth) {
-				const auto pred = [level, maximizing] (const auto lhs, const auto rhs) {
-					if(maximizing) {
-						return lhs.score() > rhs.score();
-					} else {
-						return lhs.score() < rhs.score();
-					}
-				};
-				std::sort(moves.begin(), moves.begin() + len, pred);
-			}
-
-			std::array<Score, upperLimitMoves> results;
-			Score newScore = maximizing ? - static_cast<Score>(boardSize * boardSize) : static_cast<Score>(boardSize * boardSize);
-			uint32_t newIndex = 0;
-			// Now descend one further for each possible new status.
-			for(uint32_t i = 0; i != len; ++i) {
-				results[i] = minimax<depth>(moves[i], nullptr, level - 1, alpha, beta);
-				if(maximizing) {
-					if(results[i] > newScore) {
-						newScore = results[i];
-						newIndex = i;
-					}
-					if(results[i] > alpha) {
-						alpha = results[i];
+			//! The size of the table in bytes
+			std::size_t size() const noexcept
+			{
+				return (mask_ + 1) * sizeof(Bucket);
+			}
+
+			//! Look up a Status
+			/*!
+			 * \param[in] key The key of the Status
+			 * \param[out] entry Receives the stored entry if there is one
+			 * \return Whether there was an entry
+			 */
+			bool probe(const uint64_t key, TTEntry & entry) const noexcept
+			{
+				for(auto const & slot : buckets_[key & mask_].slots) {
+					const auto data = slot.data.load(std::memory_order_relaxed);
+					if((slot.check.load(std::memory_order_relaxed) ^ data) == key && bound(data) != Bound::None) {
+						entry = TTEntry{
+							static_cast<int16_t>(data & 0xffff),
+							move(data),
+							static_cast<uint32_t>((data >> 32) & 0xff),
+							bound(data)};
+						return true;
 					}
-					if(beta <= alpha) {
+				}
+				return false;
+			}
+
+			//! Store the result of searching a Status
+			/*!
+			 * \param[in] key The key of the Status
+			 * \param[in] score The score found
+			 * \param[in] m The best move found, or Move::pass() if none is known
+			 * \param[in] depth How many levels below the Status were searched
+			 * \param[in] b What score means
+			 */
+			void store(const uint64_t key, const Score score, Move m, const uint32_t depth, const Bound b) noexcept
+			{
+				assert(score >= INT16_MIN && score <= INT16_MAX);
+				auto & slots = buckets_[key & mask_].slots;
+				const auto generation = generation_.load(std::memory_order_relaxed);
+				auto victim = slots.begin();
+				int32_t victimWorth = INT32_MAX;
+				for(auto slot = slots.begin(); slot != slots.end(); ++slot) {
+					const auto data = slot->data.load(std::memory_order_relaxed);
+					if((slot->check.load(std::memory_order_relaxed) ^ data) == key) {
+						if(m.isPass() && bound(data) != Bound::None) {
+							// Keep the move we already know.
+							m = move(data);
+						}
+						victim = slot;
 						break;
 					}
-				} else {
-					if(results[i] < newScore) {
-						newScore = results[i];
-						newIndex = i;
-					}
-					if(results[i] < beta) {
-						beta = results[i];
-					}
-					if(beta <= alpha) {
-						break;
+					const auto worth = bound(data) == Bound::None ? INT32_MIN : static_cast<int32_t>((data >> 32) & 0xff) - 4 * static_cast<int32_t>((generation - (data >> 42)) & generationMask);
+					if(worth < victimWorth) {
+						victimWorth = worth;
+						victim = slot;
 					}
 				}
+				const uint64_t data =
+					static_cast<uint64_t>(static_cast<uint16_t>(score))
+					| static_cast<uint64_t>(m.from) << 16
+					| static_cast<uint64_t>(m.to) << 24
+					| static_cast<uint64_t>(std::min<uint32_t>(depth, 0xff)) << 32
+					| static_cast<uint64_t>(b) << 40
+					| generation << 42;
+				victim->check.store(key ^ data, std::memory_order_relaxed);
+				victim->data.store(data, std::memory_order_relaxed);
+			}
+
+		private:
+			//! One entry, the data being packed as score (16 bits), move (16), depth (8), bound (2) and generation (6)
+			struct Slot
+			{
+				//! The key xor data
+				std::atomic<uint64_t> check;
+				std::atomic<uint64_t> data;
+			};
+
+			struct alignas(64) Bucket
+			{
+				std::array<Slot, 4> slots;
+			};
+
+			static_assert(sizeof(Bucket) == 64, "A Bucket should fill exactly one cache line.");
+
+			static constexpr uint64_t generationMask = 0x3f;
+
+			static constexpr Bound bound(const uint64_t data) noexcept
+			{
+				return static_cast<Bound>((data >> 40) & 3);
 			}
-			if(nextStatus != nullptr) {
-				// Save the next status.
-				*nextStatus = moves[newIndex];
+
+			static constexpr Move move(const uint64_t data) noexcept
+			{
+				return Move{static_cast<uint8_t>(data >> 16), static_cast<uint8_t>(data >> 24)};
 			}
-			return newScore;
+
+			//! The memory buckets_ points into
+			std::unique_ptr<char[]> memory_;
+
+			Bucket * buckets_ = nullptr;
+
+			//! The number of buckets minus one
+			std::size_t mask_ = 0;
+
+			//! The age of the current search
+			std::atomic<uint64_t> generation_{0};
+	};
+
+	namespace detail {
+		//! Count for every move the blobs of the waiting player it captures
+		/*!
+		 * With AVX2, four moves are counted at once using a nibble lookup table.
+		 * Define ATASOL_NO_AVX2 to always use the scalar version.
+		 * \param[in] opponent The blobs of the player that is not moving
+		 * \param[in] moves The moves, none of which may be a pass
+		 * \param[in] len The number of moves
+		 * \param[out] counts Receives the number of captured blobs of every move
+		 */
+		template<uint32_t Size>
+			void captureCounts(const Bitboard opponent, Move const * moves, const uint32_t len, uint8_t * counts) noexcept
+			{
+				uint32_t i = 0;
+#ifdef ATASOL_AVX2
+				const __m256i lookup = _mm256_setr_epi8(
+						0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+						0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+				const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+				const __m256i waiting = _mm256_set1_epi64x(static_cast<long long>(opponent));
+				for(; i + 4 <= len; i += 4) {
+					const __m256i captured = _mm256_and_si256(waiting, _mm256_setr_epi64x(
+								static_cast<long long>(neighbourMasks<Size>[moves[i].to]),
+								static_cast<long long>(neighbourMasks<Size>[moves[i + 1].to]),
+								static_cast<long long>(neighbourMasks<Size>[moves[i + 2].to]),
+								static_cast<long long>(neighbourMasks<Size>[moves[i + 3].to])));
+					const __m256i nibbleCounts = _mm256_add_epi8(
+							_mm256_shuffle_epi8(lookup, _mm256_and_si256(captured, lowNibbles)),
+							_mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(captured, 4), lowNibbles)));
+					// Sum up the bytes of every 64 bit lane.
+					const __m256i sums = _mm256_sad_epu8(nibbleCounts, _mm256_setzero_si256());
+					counts[i] = static_cast<uint8_t>(_mm256_extract_epi64(sums, 0));
+					counts[i + 1] = static_cast<uint8_t>(_mm256_extract_epi64(sums, 1));
+					counts[i + 2] = static_cast<uint8_t>(_mm256_extract_epi64(sums, 2));
+					counts[i + 3] = static_cast<uint8_t>(_mm256_extract_epi64(sums, 3));
+				}
+#endif
+				for(; i != len; ++i) {
+					counts[i] = static_cast<uint8_t>(popcount(neighbourMasks<Size>[moves[i].to] & opponent));
+				}
+			}
+	}
+
+	//! Append an index of a Status in human readable format to a string
+	template<uint32_t Size = boardSize>
+		void appendIndex(std::string & out, const uint32_t index)
+		{
+			assert(index < Size * Size);
+			const auto row = index / Size;
+			const auto col = index % Size;
+			out += static_cast<char>(col + 'A');
+			out += static_cast<char>(row + '0');
 		}
 
 	//! Turn an index of a Status into human readable format
-	inline std::string indexString(uint32_t index)
-	{
-		std::stringstream ss;
-		assert(index < boardSize * boardSize);
-		const auto row = index / boardSize;
-		const auto col = index % boardSize;
-		ss << static_cast<char>(col + 'A');
-		ss << static_cast<char>(row + '0');
-		return ss.str();
-	}
+	template<uint32_t Size = boardSize>
+		std::string indexString(uint32_t index)
+		{
+			std::string r;
+			appendIndex<Size>(r, index);
+			return r;
+		}
 
 	//! Print the move from one Status to another one in human readable form
-	inline std::string moveString(Status const & first, Status const & second)
-	{
-		assert(first.whiteMoves() != second.whiteMoves());
-		std::stringstream ss;
+	template<uint32_t Size>
+		std::string moveString(BasicStatus<Size> const & first, BasicStatus<Size> const & second)
+		{
+			assert(first.whiteMoves() != second.whiteMoves());
+			std::string r;
 
-		uint32_t fromJump = static_cast<uint32_t>(-1);
-		uint32_t newBlob = static_cast<uint32_t>(-1);
-		for(uint32_t i = 0; i != boardSize * boardSize; ++i) {
-			// See if there is somthing that became empty -- only possible if a jump occured.
-			if(second[i] == Entry::Empty && first[i] != Entry::Empty) {
-				fromJump = i;
+			uint32_t fromJump = static_cast<uint32_t>(-1);
+			uint32_t newBlob = static_cast<uint32_t>(-1);
+			for(uint32_t i = 0; i != Size * Size; ++i) {
+				// See if there is somthing that became empty -- only possible if a jump occured.
+				if(second[i] == Entry::Empty && first[i] != Entry::Empty) {
+					fromJump = i;
+				}
+				if(first[i] == Entry::Empty && second[i] != Entry::Empty) {
+					newBlob = i;
+				}
 			}
-			if(first[i] == Entry::Empty && second[i] != Entry::Empty) {
-				newBlob = i;
+			assert(newBlob != static_cast<uint32_t>(-1));
+			if(fromJump != static_cast<uint32_t>(-1)) {
+				appendIndex<Size>(r, fromJump);
 			}
+			appendIndex<Size>(r, newBlob);
+			return r;
 		}
-		assert(newBlob != static_cast<uint32_t>(-1));
-		if(fromJump != static_cast<uint32_t>(-1)) {
-			ss << indexString(fromJump);
+
+	//! Append a Move on a board of the given size in human readable form to a string
+	template<uint32_t Size = boardSize>
+		void appendMove(std::string & out, const Move m)
+		{
+			if(m.isPass()) {
+				out += "pass";
+				return;
+			}
+			if(m.isJump()) {
+				appendIndex<Size>(out, m.from);
+			}
+			appendIndex<Size>(out, m.to);
 		}
-		ss << indexString(newBlob);
-		return ss.str();
+
+	//! Print a Move on a board of the given size in human readable form
+	template<uint32_t Size = boardSize>
+		std::string moveString(const Move m)
+		{
+			std::string r;
+			appendMove<Size>(r, m);
+			return r;
+		}
+
+	//! The board size of a FEN string, which is its number of rows, or zero if there are none
+	inline uint32_t fenBoardSize(std::string const & fen) noexcept
+	{
+		const auto end = fen.find(' ');
+		if(end == 0 || fen.empty()) {
+			return 0;
+		}
+		return static_cast<uint32_t>(std::count(fen.begin(), end == std::string::npos ? fen.end() : fen.begin() + static_cast<std::ptrdiff_t>(end), '/')) + 1;
 	}
+
+	//! Parse the fields and the player to move from a FEN string such as "x5o/7/2-1-2/7/2-1-2/7/o5x x 0 1"
+	/*!
+	 * The rows are given in the order BasicStatus::to_string() prints them, separated by slashes.
+	 * Within a row, x is a white blob, o a black blob, - a blocked field, and a digit stands for that many empty fields.
+	 * The rows are followed by x or o for the player to move, further fields such as move counters are ignored.
+	 * \param[in] fen The FEN string, which must have Size rows, see fenBoardSize()
+	 * \param[out] status Receives the parsed Status, it is unchanged if fen is invalid
+	 * \return Whether fen was valid
+	 */
+	template<uint32_t Size>
+		bool parseFen(std::string const & fen, BasicStatus<Size> & status)
+		{
+			BasicStatus<Size> r;
+			uint32_t row = 0;
+			uint32_t col = 0;
+			std::size_t i = 0;
+			for(; i != fen.size() && fen[i] != ' '; ++i) {
+				const auto c = fen[i];
+				if(c == '/') {
+					if(col != Size) {
+						return false;
+					}
+					++row;
+					col = 0;
+				} else if(c >= '1' && c <= '9') {
+					col += static_cast<uint32_t>(c - '0');
+				} else if((c == 'x' || c == 'o' || c == '-') && col < Size && row < Size) {
+					r.set(row * Size + col, c == 'x' ? Entry::White : c == 'o' ? Entry::Black : Entry::Blocked);
+					++col;
+				} else {
+					return false;
+				}
+				if(col > Size || row >= Size) {
+					return false;
+				}
+			}
+			if(row != Size - 1 || col != Size) {
+				return false;
+			}
+			while(i != fen.size() && fen[i] == ' ') {
+				++i;
+			}
+			if(i == fen.size() || (fen[i] != 'x' && fen[i] != 'o') || (i + 1 != fen.size() && fen[i + 1] != ' ')) {
+				return false;
+			}
+			if(fen[i] == 'o') {
+				r.switchPlayerTurn();
+			}
+			status = r;
+			return true;
+		}
+
+	//! Convert a Status to a FEN string, see parseFen()
+	template<uint32_t Size>
+		std::string toFen(BasicStatus<Size> const & status)
+		{
+			std::string r;
+			for(uint32_t row = 0; row != Size; ++row) {
+				if(row != 0) {
+					r += '/';
+				}
+				uint32_t empty = 0;
+				for(uint32_t col = 0; col != Size; ++col) {
+					const auto v = status[row * Size + col];
+					if(v == Entry::Empty) {
+						++empty;
+						continue;
+					}
+					if(empty != 0) {
+						r += static_cast<char>('0' + empty);
+						empty = 0;
+					}
+					r += v == Entry::White ? 'x' : v == Entry::Black ? 'o' : '-';
+				}
+				if(empty != 0) {
+					r += static_cast<char>('0' + empty);
+				}
+			}
+			r += status.whiteMoves() ? " x 0 1" : " o 0 1";
+			return r;
+		}
 }
 
 #endif
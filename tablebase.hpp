@@ -0,0 +1,402 @@
+/*!
+ * \file atasol_tablebase.hpp
+ * \brief atasol retrograde endgame tablebase
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_TABLEBASE_HPP_
+#define ATASOL_TABLEBASE_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapping.hpp"
+#include "solver.hpp"
+
+namespace atasol {
+	//! The outcome of a Status with perfect play, from the point of view of the moving player
+	enum class TablebaseResult : uint8_t
+	{
+		Unknown = 0,
+		Win = 1,
+		Loss = 2,
+		Draw = 3, //!< A drawn end of the game, or a game that never ends
+	};
+
+	//! What generating a Tablebase found
+	struct TablebaseCounts
+	{
+		uint64_t wins = 0;
+		uint64_t losses = 0;
+		uint64_t draws = 0;
+
+		//! The number of passes over all statuses until none was resolved since the previous one
+		uint32_t sweeps = 0;
+	};
+
+	namespace detail {
+		//! Three to the power of n
+		constexpr uint64_t pow3(const uint32_t n) noexcept
+		{
+			return n == 0 ? 1 : 3 * pow3(n - 1);
+		}
+
+		//! The value of every byte when read as the lowest eight digits of a base 3 number
+		struct TernaryBytes
+		{
+			uint32_t values[256];
+
+			constexpr uint32_t operator[](uint32_t byte) const noexcept { return values[byte]; }
+		};
+
+		constexpr TernaryBytes makeTernaryBytes() noexcept
+		{
+			TernaryBytes r{};
+			for(uint32_t byte = 0; byte != 256; ++byte) {
+				for(uint32_t bit = 0; bit != 8; ++bit) {
+					if((byte >> bit) & 1) {
+						r.values[byte] += static_cast<uint32_t>(pow3(bit));
+					}
+				}
+			}
+			return r;
+		}
+
+		constexpr TernaryBytes ternaryBytes = makeTernaryBytes();
+
+		//! Three to the power of every field, wrapping around for fields that no Tablebase has
+		struct PowersOf3
+		{
+			uint64_t values[sizeof(Bitboard) * 8];
+
+			constexpr uint64_t operator[](uint32_t n) const noexcept { return values[n]; }
+		};
+
+		constexpr PowersOf3 makePowersOf3() noexcept
+		{
+			PowersOf3 r{};
+			r.values[0] = 1;
+			for(uint32_t n = 1; n != sizeof(Bitboard) * 8; ++n) {
+				r.values[n] = 3 * r.values[n - 1];
+			}
+			return r;
+		}
+
+		constexpr PowersOf3 powersOf3 = makePowersOf3();
+	}
+
+	//! Perfect play results of every Status of a small board without blocked fields, computed by retrograde analysis
+	/*!
+	 * Every field is one digit of a base 3 number, being 0 when empty, 1 for white and 2 for black.
+	 * The index of a Status is twice that number, plus one if black moves, so all statuses are ranked densely.
+	 * The file stores the results of all indices with two bits each after a short header,
+	 * and is mapped into memory instead of being read, so that only the probed parts are ever loaded.
+	 */
+	template<uint32_t Size>
+		class Tablebase
+		{
+			public:
+				//! Whether a table of this board size is small enough to be generated
+				static constexpr bool supported = Size * Size <= 16;
+
+				//! The number of indices, or zero if the board size is not supported
+				static constexpr uint64_t positions = supported ? 2 * detail::pow3(Size * Size) : 0;
+
+				//! The index of a Status, which must not have blocked fields
+				static uint64_t index(BasicStatus<Size> const & status) noexcept
+				{
+					assert(status.blocked() == 0);
+					return 2 * (ternary(status.white()) + 2 * ternary(status.black())) + (status.blackMoves() ? 1 : 0);
+				}
+
+				//! Map a file written by generate() into memory, replacing any file opened before
+				/*!
+				 * \return Whether path is a table of this board size
+				 */
+				bool open(std::string const & path)
+				{
+					if(!supported || !file_.open(path)) {
+						return false;
+					}
+					if(file_.size() != fileSize || std::memcmp(file_.data(), header().data(), header().size()) != 0) {
+						file_.close();
+						return false;
+					}
+					return true;
+				}
+
+				//! Unmap the file, if one is open
+				void close() noexcept
+				{
+					file_.close();
+				}
+
+				//! Whether a file is open
+				bool isOpen() const noexcept
+				{
+					return file_.data() != nullptr;
+				}
+
+				//! Look up a Status
+				/*!
+				 * \param[in] status The Status
+				 * \param[out] result Receives the result if the table knows it
+				 * \return Whether a file is open and status has no blocked fields
+				 */
+				bool probe(BasicStatus<Size> const & status, TablebaseResult & result) const noexcept
+				{
+					if(!isOpen() || status.blocked() != 0) {
+						return false;
+					}
+					const auto i = index(status);
+					result = static_cast<TablebaseResult>((file_.data()[headerSize + i / 4] >> (2 * (i % 4))) & 3);
+					return true;
+				}
+
+				//! Compute the results of all statuses and write them to a file that open() accepts
+				/*!
+				 * Statuses where the game is over get their final result, and every other status a count of its moves.
+				 * Then every status that became a win or a loss tells its predecessors, found by taking back moves:
+				 * a predecessor becomes a win once one of its moves leads to a loss of the opponent,
+				 * and a loss once the count of its moves that lead to wins of the opponent reaches zero.
+				 * Passes over all statuses repeat this for the statuses resolved since, until a pass finds none.
+				 * Statuses that are still unknown then never reach the end of the game with perfect play, which is a draw.
+				 * The threads pass over separate ranges of indices, and see each other's results as soon as they are stored.
+				 * \param[in] path The file to write
+				 * \param[in] threads The number of threads to use
+				 * \param[out] counts Receives what was found
+				 * \return Whether the board size is supported and the file was written
+				 */
+				static bool generate(std::string const & path, const uint32_t threads, TablebaseCounts & counts)
+				{
+					if(!supported) {
+						return false;
+					}
+					static_assert(!supported || upperLimitMoves<Size> <= UINT8_MAX, "Move counts are stored in one byte.");
+					std::unique_ptr<std::atomic<uint8_t>[]> results(new std::atomic<uint8_t>[positions]);
+					std::unique_ptr<std::atomic<uint8_t>[]> moveCounts(new std::atomic<uint8_t>[positions]);
+					const auto parallel = [threads] (auto f) {
+						const uint64_t statuses = positions / 2;
+						const uint64_t chunk = (statuses + std::max(threads, 1U) - 1) / std::max(threads, 1U);
+						std::vector<std::thread> workers;
+						for(uint64_t first = 0; first < statuses; first += chunk) {
+							workers.emplace_back(f, first, std::min(first + chunk, statuses));
+						}
+						for(auto & worker : workers) {
+							worker.join();
+						}
+					};
+
+					parallel([&results, &moveCounts] (const uint64_t first, const uint64_t last) {
+						BasicStatus<Size> status = decode(first);
+						std::array<Move, upperLimitMoves<Size>> moves;
+						for(uint64_t t = first; t != last; ++t, next(status)) {
+							for(uint64_t side = 0; side != 2; ++side) {
+								auto result = TablebaseResult::Unknown;
+								uint32_t len = 0;
+								if(status.gameOver()) {
+									const auto score = status.whiteMoves() ? status.score() : - status.score();
+									result = score > 0 ? TablebaseResult::Win : score < 0 ? TablebaseResult::Loss : TablebaseResult::Draw;
+								} else {
+									// A pass counts as one move.
+									len = std::max(generateMoves(status, moves.begin()), 1U);
+								}
+								results[2 * t + side].store(static_cast<uint8_t>(result), std::memory_order_relaxed);
+								moveCounts[2 * t + side].store(static_cast<uint8_t>(len), std::memory_order_relaxed);
+								status.switchPlayerTurn();
+							}
+						}
+					});
+
+					counts = TablebaseCounts();
+					for(;;) {
+						++counts.sweeps;
+						std::atomic<uint64_t> resolved{0};
+						parallel([&results, &moveCounts, &resolved] (const uint64_t first, const uint64_t last) {
+							uint64_t told = 0;
+							BasicStatus<Size> status = decode(first);
+							for(uint64_t t = first; t != last; ++t, next(status)) {
+								for(uint64_t side = 0; side != 2; ++side) {
+									const auto i = 2 * t + side;
+									// Only the thread of i marks it as told, and other threads only store results of unknown statuses.
+									const auto result = static_cast<TablebaseResult>(results[i].load(std::memory_order_relaxed));
+									if(result == TablebaseResult::Win || result == TablebaseResult::Loss) {
+										results[i].store(static_cast<uint8_t>(static_cast<uint8_t>(result) | toldFlag), std::memory_order_relaxed);
+										tellPredecessors(status, result, results.get(), moveCounts.get());
+										++told;
+									}
+									status.switchPlayerTurn();
+								}
+							}
+							resolved += told;
+						});
+						if(resolved == 0) {
+							break;
+						}
+					}
+
+					std::vector<unsigned char> packed(fileSize - headerSize, 0);
+					for(uint64_t i = 0; i != positions; ++i) {
+						auto result = static_cast<TablebaseResult>(results[i].load(std::memory_order_relaxed) & ~toldFlag);
+						if(result == TablebaseResult::Unknown) {
+							result = TablebaseResult::Draw;
+						}
+						counts.wins += result == TablebaseResult::Win ? 1 : 0;
+						counts.losses += result == TablebaseResult::Loss ? 1 : 0;
+						counts.draws += result == TablebaseResult::Draw ? 1 : 0;
+						packed[i / 4] = static_cast<unsigned char>(packed[i / 4] | static_cast<uint32_t>(result) << (2 * (i % 4)));
+					}
+					std::ofstream file(path, std::ios::binary | std::ios::trunc);
+					file.write(header().data(), static_cast<std::streamsize>(header().size()));
+					file.write(reinterpret_cast<char const *>(packed.data()), static_cast<std::streamsize>(packed.size()));
+					return static_cast<bool>(file);
+				}
+
+			private:
+				//! The size of the header, which is "atasoltb" followed by the board size as a digit and padding
+				static constexpr std::size_t headerSize = 16;
+
+				static constexpr uint64_t fileSize = headerSize + (positions + 3) / 4;
+
+				static std::array<char, headerSize> header() noexcept
+				{
+					std::array<char, headerSize> r{{'a', 't', 'a', 's', 'o', 'l', 't', 'b', static_cast<char>('0' + Size)}};
+					return r;
+				}
+
+				//! The base 3 number with a one at the digit of every field of b
+				static uint64_t ternary(Bitboard b) noexcept
+				{
+					uint64_t r = 0;
+					for(uint32_t shift = 0; b != 0; shift += 8, b >>= 8) {
+						r += detail::ternaryBytes[b & 0xff] * detail::powersOf3[shift];
+					}
+					return r;
+				}
+
+				//! The Status with white to move whose fields are the digits of t
+				static BasicStatus<Size> decode(uint64_t t) noexcept
+				{
+					BasicStatus<Size> r;
+					for(uint32_t pos = 0; pos != Size * Size; ++pos, t /= 3) {
+						r.set(pos, t % 3 == 1 ? Entry::White : t % 3 == 2 ? Entry::Black : Entry::Empty);
+					}
+					return r;
+				}
+
+				//! Advance a Status with white to move to the one of the next base 3 number
+				static void next(BasicStatus<Size> & status) noexcept
+				{
+					for(uint32_t pos = 0; pos != Size * Size; ++pos) {
+						const auto e = status[pos];
+						if(e == Entry::Empty) {
+							status.set(pos, Entry::White);
+							return;
+						} else if(e == Entry::White) {
+							status.set(pos, Entry::Black);
+							return;
+						}
+						status.set(pos, Entry::Empty);
+					}
+				}
+
+				//! Marks a result in generate() whose predecessors were told about it
+				static constexpr uint8_t toldFlag = 4;
+
+				//! Tell every predecessor of a Status about its result, see generate()
+				/*!
+				 * A predecessor is found by taking back a move of the player that is not moving in status:
+				 * a blob of that player on a field to came from an empty field two fields away,
+				 * or was spawned from a blob next to it, and any subset of its blobs next to to may have been captured,
+				 * unless the moving player has blobs next to to, which the move would have captured as well.
+				 * A predecessor with the same fields has passed if its player has no move.
+				 * \param[in] status The Status
+				 * \param[in] result The result of status, a win or a loss
+				 * \param[in,out] results The results known so far
+				 * \param[in,out] moveCounts The moves of every unknown status that do not lead to a known win of the opponent
+				 */
+				static void tellPredecessors(BasicStatus<Size> const & status, const TablebaseResult result,
+						std::atomic<uint8_t> * results, std::atomic<uint8_t> * moveCounts) noexcept
+				{
+					const bool whiteMoved = status.blackMoves();
+					const auto moved = status.waitingBlobs();
+					const auto moving = status.movingBlobs();
+					const auto empty = status.empty();
+					const auto tell = [=] (const Bitboard movedBefore, const Bitboard movingBefore) {
+						const auto white = whiteMoved ? movedBefore : movingBefore;
+						const auto black = whiteMoved ? movingBefore : movedBefore;
+						const auto i = 2 * (ternary(white) + 2 * ternary(black)) + (whiteMoved ? 0 : 1);
+						if(static_cast<TablebaseResult>(results[i].load(std::memory_order_relaxed)) != TablebaseResult::Unknown) {
+							return;
+						}
+						auto unknown = static_cast<uint8_t>(TablebaseResult::Unknown);
+						if(result == TablebaseResult::Loss) {
+							results[i].compare_exchange_strong(unknown, static_cast<uint8_t>(TablebaseResult::Win), std::memory_order_relaxed);
+						} else if(moveCounts[i].fetch_sub(1, std::memory_order_relaxed) == 1) {
+							results[i].compare_exchange_strong(unknown, static_cast<uint8_t>(TablebaseResult::Loss), std::memory_order_relaxed);
+						}
+					};
+
+					for(auto blobs = moved; blobs != 0; ) {
+						const auto to = detail::popLowest(blobs);
+						const auto around = detail::neighbourMasks<Size>[to];
+						if((around & moving) != 0) {
+							continue;
+						}
+						const auto capturable = around & moved;
+						for(auto captured = capturable; ; captured = (captured - 1) & capturable) {
+							const auto movedBefore = moved & ~captured & ~(Bitboard{1} << to);
+							const auto movingBefore = moving | captured;
+							if((around & movedBefore) != 0) {
+								tell(movedBefore, movingBefore);
+							}
+							for(auto froms = detail::jumpMasks<Size>[to] & empty; froms != 0; ) {
+								tell(movedBefore | Bitboard{1} << detail::popLowest(froms), movingBefore);
+							}
+							if(captured == 0) {
+								break;
+							}
+						}
+					}
+					if((detail::dilate<Size>(detail::dilate<Size>(moved)) & empty) == 0) {
+						tell(moved, moving);
+					}
+				}
+
+				//! The results after the header
+				MappedFile file_;
+		};
+}
+
+#endif
@@ -0,0 +1,472 @@
+/*!
+ * \file atasol_uai.hpp
+ * \brief atasol Universal Ataxx Interface engine protocol
+ *
+ * Copyright (c) 2016, Christoph Weiss
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATASOL_UAI_HPP_
+#define ATASOL_UAI_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "book.hpp"
+#include "mcts.hpp"
+#include "nnue.hpp"
+#include "search.hpp"
+#include "solver.hpp"
+#include "tablebase.hpp"
+
+namespace atasol {
+	//! Append a Move in UAI notation to a string
+	/*!
+	 * Columns are letters from a and rows are numbers from 1, counted from the bottom row that BasicStatus::to_string() prints last.
+	 * A spawn is its field such as "b2", a jump the two fields such as "a1c3", and a pass is "0000".
+	 */
+	template<uint32_t Size>
+		void appendUaiMove(std::string & out, const Move m)
+		{
+			if(m.isPass()) {
+				out += "0000";
+				return;
+			}
+			const auto field = [&out] (const uint32_t pos) {
+				out += static_cast<char>('a' + pos % Size);
+				// Boards have at most eight rows.
+				out += static_cast<char>('0' + Size - pos / Size);
+			};
+			if(m.isJump()) {
+				field(m.from);
+			}
+			field(m.to);
+		}
+
+	//! Print a Move in UAI notation, see appendUaiMove()
+	template<uint32_t Size>
+		std::string uaiMove(const Move m)
+		{
+			std::string r;
+			appendUaiMove<Size>(r, m);
+			return r;
+		}
+
+	//! Parse a Move in UAI notation, see uaiMove()
+	/*!
+	 * \param[in] s The move
+	 * \param[in] status The Status the move is made in
+	 * \param[out] m Receives the move, it is unchanged if s is not a legal move in status
+	 * \return Whether s is a legal move in status, where a pass is only legal if there is no other move
+	 */
+	template<uint32_t Size>
+		bool parseUaiMove(std::string const & s, BasicStatus<Size> const & status, Move & m)
+		{
+			std::array<Move, upperLimitMoves<Size>> moves;
+			const auto len = generateMoves(status, moves.begin());
+			const auto found = std::find_if(moves.begin(), moves.begin() + len, [&s] (const Move candidate) { return uaiMove<Size>(candidate) == s; });
+			if(found != moves.begin() + len) {
+				m = *found;
+				return true;
+			}
+			if(len == 0 && s == "0000" && !status.gameOver()) {
+				m = Move::pass();
+				return true;
+			}
+			return false;
+		}
+
+	//! An engine speaking the Universal Ataxx Interface on a board of Size x Size fields
+	/*!
+	 * Commands are passed in line by line, and replies are written to an output stream.
+	 * Searches run on a worker thread, so that commands such as stop and isready are answered while searching.
+	 * Supported are uai, isready, setoption (Hash, Threads, Engine and MultiPV), uainewgame, position (startpos or fen, followed by moves),
+	 * go (depth, nodes, movetime, wtime, btime, winc, binc, movestogo and infinite), stop and quit.
+	 * A position command that is rejected leaves no position to search, so go only reports an error until a valid position or uainewgame.
+	 * With wtime or btime, the time of a move is budgeted by budgetTime(), taking negative clocks, as sent past the flag, as no time left.
+	 * A movetime of zero or less searches for the minimal time, and the mcts engine reports that it ignores depth.
+	 * An infinite search holds back its bestmove until stop or quit, even if it reaches the deepest iteration before.
+	 * The Engine option chooses between the alpha-beta BasicParallelSearcher and the BasicMctsSearcher,
+	 * whose node pool then takes the Hash megabytes in place of the TranspositionTable.
+	 * With MultiPV above one, alpha-beta ranks that many root moves, and every iteration writes one info line for each of them, numbered by multipv.
+	 * A status found in the OpeningBook is answered with its book move right away, unless the search is infinite.
+	 */
+	template<uint32_t Size>
+		class UaiEngine
+		{
+			public:
+				/*!
+				 * \param[in] out Where replies are written to
+				 * \param[in] hashMegabytes The initial size of the TranspositionTable
+				 * \param[in] threads The initial number of search threads
+				 * \param[in] tablebase The Tablebase that the searches probe, or nullptr
+				 * \param[in] network The Network that evaluates statuses, or nullptr to use BasicStatus::evaluation()
+				 * \param[in] book The OpeningBook that moves are taken from before searching, or nullptr
+				 */
+				UaiEngine(std::ostream & out, const std::size_t hashMegabytes, const uint32_t threads, Tablebase<Size> const * tablebase = nullptr,
+						Network<Size> const * network = nullptr, OpeningBook<Size> const * book = nullptr) :
+					out_(out),
+					hashMegabytes_(hashMegabytes),
+					threads_(threads),
+					tablebase_(tablebase),
+					network_(network),
+					book_(book),
+					table_(hashMegabytes),
+					searcher_(new BasicParallelSearcher<Size>(&table_, threads, tablebase, network)),
+					status_(startingStatus<Size>())
+				{
+				}
+
+				UaiEngine(UaiEngine const &) = delete;
+				UaiEngine & operator=(UaiEngine const &) = delete;
+
+				~UaiEngine()
+				{
+					stopSearch();
+				}
+
+				//! Handle one command
+				/*!
+				 * \return Whether more commands should follow, which is false after quit
+				 */
+				bool command(std::string const & line)
+				{
+					std::istringstream in(line);
+					std::string name;
+					in >> name;
+					if(name == "uai") {
+						write("id name atasol\nid author Christoph Weiss\n"
+							"option name Hash type spin default " + std::to_string(hashMegabytes_) + " min 1 max 1048576\n"
+							"option name Threads type spin default " + std::to_string(threads_) + " min 1 max 1024\n"
+							"option name Engine type combo default alphabeta var alphabeta var mcts\n"
+							"option name MultiPV type spin default 1 min 1 max " + std::to_string(maxMultiPv) + "\n"
+							"uaiok");
+					} else if(name == "isready") {
+						write("readyok");
+					} else if(name == "setoption") {
+						stopSearch();
+						setOption(in);
+					} else if(name == "uainewgame") {
+						stopSearch();
+						table_.clear();
+						if(mcts_) {
+							mcts_->clear();
+						}
+						status_ = startingStatus<Size>();
+						validPosition_ = true;
+					} else if(name == "position") {
+						stopSearch();
+						position(in);
+					} else if(name == "go") {
+						stopSearch();
+						go(in);
+					} else if(name == "stop") {
+						stopSearch();
+					} else if(name == "quit") {
+						stopSearch();
+						return false;
+					} else if(!name.empty()) {
+						write("info string unknown command " + name);
+					}
+					return true;
+				}
+
+			private:
+				//! Write lines to the output, which the worker thread does as well
+				void write(std::string const & lines)
+				{
+					std::lock_guard<std::mutex> lock(outMutex_);
+					out_ << lines << std::endl;
+				}
+
+				//! Give the Hash megabytes to the TranspositionTable or to the node pool of the BasicMctsSearcher, and shrink the other to nothing
+				void allocate(const bool mcts)
+				{
+					// Free before allocating, so that both never take the Hash megabytes at once.
+					mcts_.reset();
+					table_.resize(mcts ? 0 : hashMegabytes_);
+					if(mcts) {
+						mcts_.reset(new BasicMctsSearcher<Size>(threads_, hashMegabytes_));
+					}
+				}
+
+				void setOption(std::istringstream & in)
+				{
+					std::string token;
+					std::string name;
+					std::string value;
+					in >> token >> name >> token >> value;
+					if(name == "Engine" && token == "value" && (value == "alphabeta" || value == "mcts")) {
+						allocate(value == "mcts");
+						return;
+					}
+					char * end;
+					const auto n = std::strtoul(value.c_str(), &end, 10);
+					if(token != "value" || *end != '\0' || n == 0) {
+						write("info string invalid setoption");
+					} else if(name == "Hash") {
+						hashMegabytes_ = std::min<std::size_t>(n, 1 << 20);
+						allocate(mcts_ != nullptr);
+					} else if(name == "MultiPV") {
+						multiPv_ = static_cast<uint32_t>(std::min<unsigned long>(n, maxMultiPv));
+					} else if(name == "Threads") {
+						threads_ = static_cast<uint32_t>(std::min<unsigned long>(n, 1024));
+						searcher_.reset(new BasicParallelSearcher<Size>(&table_, threads_, tablebase_, network_));
+						if(mcts_) {
+							mcts_.reset();
+							mcts_.reset(new BasicMctsSearcher<Size>(threads_, hashMegabytes_));
+						}
+					} else {
+						write("info string unknown option " + name);
+					}
+				}
+
+				void position(std::istringstream & in)
+				{
+					// Until the position turns out valid, there is none to search.
+					validPosition_ = false;
+					std::string token;
+					in >> token;
+					BasicStatus<Size> status = startingStatus<Size>();
+					if(token == "fen") {
+						std::string fen;
+						while(in >> token && token != "moves") {
+							fen += (fen.empty() ? "" : " ") + token;
+						}
+						if(fenBoardSize(fen) != Size || !parseFen(fen, status)) {
+							write("info string invalid fen for a " + std::to_string(Size) + "x" + std::to_string(Size) + " board " + fen);
+							return;
+						}
+					} else if(token == "startpos") {
+						in >> token;
+					} else {
+						write("info string invalid position");
+						return;
+					}
+					if(token == "moves") {
+						while(in >> token) {
+							Move m;
+							if(!parseUaiMove(token, status, m)) {
+								write("info string illegal move " + token);
+								return;
+							}
+							status.play(m);
+						}
+					}
+					status_ = status;
+					validPosition_ = true;
+				}
+
+				void go(std::istringstream & in)
+				{
+					if(!validPosition_) {
+						write("info string no valid position to search");
+						return;
+					}
+					limits_ = SearchLimits();
+					limits_.depth = maxDepth - 1;
+					limits_.multiPv = multiPv_;
+					std::chrono::milliseconds budget{0};
+					// The clocks of white and black, or -1 if not given, and negative values are taken as no time left.
+					int64_t time[2] = {-1, -1};
+					int64_t increment[2] = {0, 0};
+					int64_t movesToGo = 0;
+					bool infinite = false;
+					std::string token;
+					while(in >> token) {
+						int64_t value = 0;
+						if(token != "infinite" && !(in >> value)) {
+							break;
+						}
+						if(token == "infinite") {
+							infinite = true;
+						} else if(token == "depth" && value > 0) {
+							limits_.depth = static_cast<uint32_t>(std::min<int64_t>(value, maxDepth - 1));
+							if(mcts_) {
+								write("info string depth ignored, mcts does not search to a depth");
+							}
+						} else if(token == "nodes" && value > 0) {
+							limits_.nodes = static_cast<uint64_t>(value);
+						} else if(token == "movetime") {
+							// A movetime of zero or less leaves the minimal budget of one millisecond.
+							budget = std::chrono::milliseconds(std::max<int64_t>(value, 1));
+						} else if(token == "wtime" || token == "btime") {
+							time[token[0] == 'w' ? 0 : 1] = std::max<int64_t>(value, 0);
+						} else if(token == "winc" || token == "binc") {
+							increment[token[0] == 'w' ? 0 : 1] = std::max<int64_t>(value, 0);
+						} else if(token == "movestogo" && value > 0) {
+							movesToGo = value;
+						}
+					}
+					const auto own = status_.whiteMoves() ? 0 : 1;
+					if(budget.count() == 0 && time[own] >= 0) {
+						budgetTime(limits_, std::chrono::milliseconds(time[own]), std::chrono::milliseconds(increment[own]),
+								static_cast<uint32_t>(std::min<int64_t>(movesToGo, UINT32_MAX)), detail::popcount(status_.empty()));
+					}
+					BookEntry entry;
+					if(!infinite && book_ != nullptr && book_->probe(status_, entry)) {
+						write("info depth " + std::to_string(entry.depth) + " score cp " + std::to_string(100 * entry.score / blobScore)
+								+ " nodes 0 pv " + uaiMove<Size>(entry.move) + "\nbestmove " + uaiMove<Size>(entry.move));
+						return;
+					}
+
+					stop_.store(false, std::memory_order_relaxed);
+					limits_.stop = &stop_;
+					const auto start = std::chrono::steady_clock::now();
+					const bool whiteMoves = status_.whiteMoves();
+					limits_.progress = [this, start, whiteMoves] (SearchResult const & result) {
+						write(info(result, whiteMoves, std::chrono::steady_clock::now() - start));
+					};
+					finished_ = false;
+					worker_ = std::thread([this, budget, infinite] {
+						if(budget.count() > 0) {
+							timer_ = std::thread([this, budget] {
+								std::unique_lock<std::mutex> lock(finishedMutex_);
+								if(!finishedChanged_.wait_for(lock, budget, [this] { return finished_; })) {
+									stop_.store(true, std::memory_order_relaxed);
+								}
+							});
+						}
+						const auto result = mcts_ ? mcts_->search(status_, limits_) : searcher_->search(status_, limits_);
+						{
+							std::lock_guard<std::mutex> lock(finishedMutex_);
+							finished_ = true;
+						}
+						finishedChanged_.notify_all();
+						if(timer_.joinable()) {
+							timer_.join();
+						}
+						if(infinite) {
+							// The bestmove of an infinite search must not come before stop, even if the search ended by itself.
+							std::unique_lock<std::mutex> lock(finishedMutex_);
+							finishedChanged_.wait(lock, [this] { return stop_.load(std::memory_order_relaxed); });
+						}
+						write("bestmove " + uaiMove<Size>(result.move));
+					});
+				}
+
+				//! The info lines about a completed iteration, one for every ranked root move if there are SearchResult::lines
+				static std::string info(SearchResult const & result, const bool whiteMoves, const std::chrono::steady_clock::duration elapsed)
+				{
+					const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+					// multiPv is the number of the ranked root move, or zero without SearchResult::lines.
+					const auto line = [&] (const std::size_t multiPv, const Score score, std::vector<Move> const & pv) {
+						std::string r = "info depth " + std::to_string(result.depth);
+						if(multiPv != 0) {
+							r += " multipv " + std::to_string(multiPv);
+						}
+						r += " score cp " + std::to_string(100 * (whiteMoves ? score : - score) / blobScore)
+							+ " nodes " + std::to_string(result.nodes)
+							+ " time " + std::to_string(milliseconds)
+							+ " nps " + std::to_string(result.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(milliseconds, 1)))
+							+ " pv";
+						for(const auto m : pv) {
+							r += ' ';
+							appendUaiMove<Size>(r, m);
+						}
+						return r;
+					};
+					if(result.lines.empty()) {
+						return line(0, result.score, result.pv);
+					}
+					std::string r;
+					for(std::size_t i = 0; i != result.lines.size(); ++i) {
+						r += (i == 0 ? "" : "\n") + line(i + 1, result.lines[i].score, result.lines[i].pv);
+					}
+					return r;
+				}
+
+				//! Stop a running search and wait for its bestmove
+				void stopSearch()
+				{
+					if(worker_.joinable()) {
+						{
+							std::lock_guard<std::mutex> lock(finishedMutex_);
+							stop_.store(true, std::memory_order_relaxed);
+						}
+						finishedChanged_.notify_all();
+						worker_.join();
+					}
+				}
+
+				std::ostream & out_;
+				std::mutex outMutex_;
+
+				std::size_t hashMegabytes_;
+				uint32_t threads_;
+				Tablebase<Size> const * tablebase_;
+				Network<Size> const * network_;
+				OpeningBook<Size> const * book_;
+
+				TranspositionTable table_;
+				std::unique_ptr<BasicParallelSearcher<Size>> searcher_;
+
+				//! The largest MultiPV option
+				static constexpr uint32_t maxMultiPv = 256;
+
+				//! How many root moves searches rank, from the MultiPV option
+				uint32_t multiPv_ = 1;
+
+				//! The searcher used instead of searcher_ when the Engine option is mcts
+				std::unique_ptr<BasicMctsSearcher<Size>> mcts_;
+
+				//! The Status of the last position command
+				BasicStatus<Size> status_;
+
+				//! Whether status_ is what the last position command set, which is false after that command was rejected
+				bool validPosition_ = true;
+
+				//! The limits of the running search, which has to stop when stop_ is set
+				SearchLimits limits_;
+				std::atomic<bool> stop_{false};
+
+				//! The thread running the search
+				std::thread worker_;
+
+				//! The thread setting stop_ once the time of the running search is up
+				std::thread timer_;
+
+				//! Whether the running search finished, which lets the timer return early
+				bool finished_ = false;
+				std::mutex finishedMutex_;
+				//! Signals changes of finished_, and of stop_ that an infinite search waits for before its bestmove
+				std::condition_variable finishedChanged_;
+		};
+
+	template<uint32_t Size>
+		constexpr uint32_t UaiEngine<Size>::maxMultiPv;
+}
+
+#endif